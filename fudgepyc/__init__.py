@@ -18,10 +18,17 @@ from fudgepyc.impl import __doc__, \
                           __file__, \
                           __version__, \
                           init, \
+                          decodeParallel, \
+                          nameCacheStats, \
+                          clearNameCache, \
+                          loads, \
+                          dumps, \
                           Envelope, \
                           Exception, \
                           Field, \
-                          Message
+                          Message, \
+                          MessageTemplate, \
+                          StreamDecoder
 import fudgepyc.timezone
 import fudgepyc.types
 
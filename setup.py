@@ -26,7 +26,7 @@ def _makeExtension ( name ):
     return Extension ( name = 'fudgepyc.' + name,
                        sources = [ _srcdir + n for n in _sources [ name ] ],
                        depends = [ _srcdir + n for n in _depends [ name ] ],
-                       libraries = [ 'fudgec' ] )
+                       libraries = [ 'fudgec', 'pthread' ] )
 
 
 class TestStreamOutput ( object ):
@@ -107,22 +107,38 @@ class TestCommand ( Command ):
 
 _srcdir = 'src/'
 
-_sources = { 'impl'  : [ 'converters.c',
+_sources = { 'impl'  : [ 'content.c',
+                         'converters.c',
+                         'dictcodec.c',
                          'envelope.c',
                          'exception.c',
                          'field.c',
+                         'fieldindex.c',
                          'message.c',
+                         'messagetemplate.c',
                          'implmodule.c',
-                         'modulemethods.c' ],
+                         'modulemethods.c',
+                         'namecache.c',
+                         'streamdecoder.c',
+                         'timezone.c',
+                         'wire.c' ],
              'types' : [ 'typesmodule.c' ] }
 
-_depends = { 'impl' : [ 'converters.h',
+_depends = { 'impl' : [ 'content.h',
+                        'converters.h',
+                        'dictcodec.h',
                         'envelope.h',
                         'exception.h',
                         'field.h',
+                        'fieldindex.h',
                         'message.h',
+                        'messagetemplate.h',
                         'modulemethods.h',
-                        'version.h' ],
+                        'namecache.h',
+                        'streamdecoder.h',
+                        'timezone.h',
+                        'version.h',
+                        'wire.h' ],
              'types' : [ ] }
 
 setup ( name = 'Fudge-PyC',
@@ -0,0 +1,279 @@
+/**
+ * Copyright (C) 2012 - 2012, Vrai Stacey.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "content.h"
+#include <fudge/string.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CONTENT_FNV_OFFSET  0xcbf29ce484222325ULL
+#define CONTENT_FNV_PRIME   0x100000001b3ULL
+
+/* Returns a copy of the message's fields, which the caller must free */
+static FudgeStatus content_getFields ( FudgeField * * fields,
+                                       fudge_i32 * numfields,
+                                       FudgeMsg message )
+{
+    *numfields = ( fudge_i32 ) FudgeMsg_numFields ( message );
+    if ( ! ( *fields = ( FudgeField * ) malloc ( sizeof ( FudgeField ) * ( *numfields + 1 ) ) ) )
+        return FUDGE_OUT_OF_MEMORY;
+    *numfields = FudgeMsg_getFields ( *fields, *numfields, message );
+    return FUDGE_OK;
+}
+
+static int content_isEqualString ( FudgeString x, FudgeString y )
+{
+    size_t size = FudgeString_getSize ( x );
+    return size == FudgeString_getSize ( y ) &&
+           ! memcmp ( FudgeString_getData ( x ), FudgeString_getData ( y ), size );
+}
+
+static int content_isEqualDate ( const FudgeDate * x, const FudgeDate * y )
+{
+    return x->year == y->year && x->month == y->month && x->day == y->day;
+}
+
+static int content_isEqualTime ( const FudgeTime * x, const FudgeTime * y )
+{
+    return x->seconds == y->seconds &&
+           x->nanoseconds == y->nanoseconds &&
+           x->precision == y->precision &&
+           x->hasTimezone == y->hasTimezone &&
+           ( ! x->hasTimezone || x->timezoneOffset == y->timezoneOffset );
+}
+
+static FudgeStatus content_isEqualField ( int * equal,
+                                          const FudgeField * x,
+                                          const FudgeField * y )
+{
+    *equal = x->type == y->type && x->flags == y->flags;
+    if ( *equal && ( x->flags & FUDGE_FIELD_HAS_ORDINAL ) )
+        *equal = x->ordinal == y->ordinal;
+    if ( *equal && ( x->flags & FUDGE_FIELD_HAS_NAME ) )
+        *equal = content_isEqualString ( x->name, y->name );
+    if ( ! *equal )
+        return FUDGE_OK;
+
+    switch ( x->type )
+    {
+        case FUDGE_TYPE_INDICATOR:
+            break;
+        case FUDGE_TYPE_BOOLEAN:
+            *equal = ! x->data.boolean == ! y->data.boolean;
+            break;
+        case FUDGE_TYPE_BYTE:
+            *equal = x->data.byte == y->data.byte;
+            break;
+        case FUDGE_TYPE_SHORT:
+            *equal = x->data.i16 == y->data.i16;
+            break;
+        case FUDGE_TYPE_INT:
+            *equal = x->data.i32 == y->data.i32;
+            break;
+        case FUDGE_TYPE_LONG:
+            *equal = x->data.i64 == y->data.i64;
+            break;
+        case FUDGE_TYPE_FLOAT:
+            *equal = x->data.f32 == y->data.f32;
+            break;
+        case FUDGE_TYPE_DOUBLE:
+            *equal = x->data.f64 == y->data.f64;
+            break;
+
+        case FUDGE_TYPE_STRING:
+            *equal = content_isEqualString ( x->data.string, y->data.string );
+            break;
+        case FUDGE_TYPE_FUDGE_MSG:
+            return content_isEqual ( equal, x->data.message, y->data.message );
+
+        case FUDGE_TYPE_DATE:
+            *equal = content_isEqualDate ( &x->data.datetime.date, &y->data.datetime.date );
+            break;
+        case FUDGE_TYPE_TIME:
+            *equal = content_isEqualTime ( &x->data.datetime.time, &y->data.datetime.time );
+            break;
+        case FUDGE_TYPE_DATETIME:
+            *equal = content_isEqualDate ( &x->data.datetime.date, &y->data.datetime.date ) &&
+                     content_isEqualTime ( &x->data.datetime.time, &y->data.datetime.time );
+            break;
+
+        /* Arrays, byte arrays and unknown types */
+        default:
+            *equal = x->numbytes == y->numbytes &&
+                     ! memcmp ( x->data.bytes, y->data.bytes, x->numbytes );
+            break;
+    }
+    return FUDGE_OK;
+}
+
+FudgeStatus content_isEqual ( int * equal, FudgeMsg x, FudgeMsg y )
+{
+    FudgeField * xfields = 0, * yfields = 0;
+    fudge_i32 numfields, index;
+    FudgeStatus status;
+
+    *equal = x == y;
+    if ( *equal || FudgeMsg_numFields ( x ) != FudgeMsg_numFields ( y ) )
+        return FUDGE_OK;
+
+    if ( ( status = content_getFields ( &xfields, &numfields, x ) ) != FUDGE_OK ||
+         ( status = content_getFields ( &yfields, &numfields, y ) ) != FUDGE_OK )
+        goto free_fields_and_return;
+
+    *equal = 1;
+    for ( index = 0; index < numfields && *equal && status == FUDGE_OK; ++index )
+        status = content_isEqualField ( equal, xfields + index, yfields + index );
+
+free_fields_and_return:
+    free ( xfields );
+    free ( yfields );
+    return status;
+}
+
+static void content_hashBytes ( uint64_t * hash, const void * bytes, size_t numbytes )
+{
+    const unsigned char * byte = ( const unsigned char * ) bytes;
+
+    while ( numbytes-- )
+        *hash = ( *hash ^ *byte++ ) * CONTENT_FNV_PRIME;
+}
+
+/* Values are hashed by their members, so struct padding is never hashed */
+#define CONTENT_HASH_VALUE( HASH, VALUE ) content_hashBytes ( HASH, &( VALUE ), sizeof ( VALUE ) )
+
+static void content_hashString ( uint64_t * hash, FudgeString string )
+{
+    fudge_i32 size = ( fudge_i32 ) FudgeString_getSize ( string );
+    CONTENT_HASH_VALUE( hash, size );
+    content_hashBytes ( hash, FudgeString_getData ( string ), size );
+}
+
+static void content_hashDate ( uint64_t * hash, const FudgeDate * date )
+{
+    CONTENT_HASH_VALUE( hash, date->year );
+    CONTENT_HASH_VALUE( hash, date->month );
+    CONTENT_HASH_VALUE( hash, date->day );
+}
+
+static void content_hashTime ( uint64_t * hash, const FudgeTime * time )
+{
+    int precision = time->precision;
+    fudge_byte hastimezone = time->hasTimezone ? 1 : 0;
+
+    CONTENT_HASH_VALUE( hash, time->seconds );
+    CONTENT_HASH_VALUE( hash, time->nanoseconds );
+    CONTENT_HASH_VALUE( hash, precision );
+    CONTENT_HASH_VALUE( hash, hastimezone );
+    if ( hastimezone )
+        CONTENT_HASH_VALUE( hash, time->timezoneOffset );
+}
+
+static FudgeStatus content_hashMessage ( uint64_t * hash, FudgeMsg message );
+
+static FudgeStatus content_hashField ( uint64_t * hash, const FudgeField * field )
+{
+    fudge_byte type = ( fudge_byte ) field->type,
+               boolean;
+    int flags = field->flags;
+    fudge_f32 f32;
+    fudge_f64 f64;
+
+    CONTENT_HASH_VALUE( hash, type );
+    CONTENT_HASH_VALUE( hash, flags );
+    if ( flags & FUDGE_FIELD_HAS_ORDINAL )
+        CONTENT_HASH_VALUE( hash, field->ordinal );
+    if ( flags & FUDGE_FIELD_HAS_NAME )
+        content_hashString ( hash, field->name );
+
+    switch ( field->type )
+    {
+        case FUDGE_TYPE_INDICATOR:
+            break;
+        case FUDGE_TYPE_BOOLEAN:
+            boolean = field->data.boolean ? 1 : 0;
+            CONTENT_HASH_VALUE( hash, boolean );
+            break;
+        case FUDGE_TYPE_BYTE:
+            CONTENT_HASH_VALUE( hash, field->data.byte );
+            break;
+        case FUDGE_TYPE_SHORT:
+            CONTENT_HASH_VALUE( hash, field->data.i16 );
+            break;
+        case FUDGE_TYPE_INT:
+            CONTENT_HASH_VALUE( hash, field->data.i32 );
+            break;
+        case FUDGE_TYPE_LONG:
+            CONTENT_HASH_VALUE( hash, field->data.i64 );
+            break;
+
+        /* Positive and negative zero compare equal, so must hash equal */
+        case FUDGE_TYPE_FLOAT:
+            f32 = field->data.f32 == 0 ? 0 : field->data.f32;
+            CONTENT_HASH_VALUE( hash, f32 );
+            break;
+        case FUDGE_TYPE_DOUBLE:
+            f64 = field->data.f64 == 0 ? 0 : field->data.f64;
+            CONTENT_HASH_VALUE( hash, f64 );
+            break;
+
+        case FUDGE_TYPE_STRING:
+            content_hashString ( hash, field->data.string );
+            break;
+        case FUDGE_TYPE_FUDGE_MSG:
+            return content_hashMessage ( hash, field->data.message );
+
+        case FUDGE_TYPE_DATE:
+            content_hashDate ( hash, &field->data.datetime.date );
+            break;
+        case FUDGE_TYPE_TIME:
+            content_hashTime ( hash, &field->data.datetime.time );
+            break;
+        case FUDGE_TYPE_DATETIME:
+            content_hashDate ( hash, &field->data.datetime.date );
+            content_hashTime ( hash, &field->data.datetime.time );
+            break;
+
+        /* Arrays, byte arrays and unknown types */
+        default:
+            CONTENT_HASH_VALUE( hash, field->numbytes );
+            content_hashBytes ( hash, field->data.bytes, field->numbytes );
+            break;
+    }
+    return FUDGE_OK;
+}
+
+static FudgeStatus content_hashMessage ( uint64_t * hash, FudgeMsg message )
+{
+    FudgeField * fields;
+    fudge_i32 numfields, index;
+    FudgeStatus status;
+
+    if ( ( status = content_getFields ( &fields, &numfields, message ) ) != FUDGE_OK )
+        return status;
+
+    /* The field count delimits sub-messages from the fields that follow */
+    CONTENT_HASH_VALUE( hash, numfields );
+    for ( index = 0; index < numfields && status == FUDGE_OK; ++index )
+        status = content_hashField ( hash, fields + index );
+
+    free ( fields );
+    return status;
+}
+
+FudgeStatus content_hash ( uint64_t * hash, FudgeMsg message )
+{
+    *hash = CONTENT_FNV_OFFSET;
+    return content_hashMessage ( hash, message );
+}
@@ -0,0 +1,34 @@
+/**
+ * Copyright (C) 2012 - 2012, Vrai Stacey.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef INC_FUDGEPYC_CONTENT_H
+#define INC_FUDGEPYC_CONTENT_H
+
+#include <fudge/message.h>
+#include <stdint.h>
+
+/* Comparison and hashing of message content: the fields' names, ordinals,
+ * types and values, in order. Two messages with equal content encode to
+ * the same bytes. These functions never touch Python objects. */
+
+/* Sets equal to true if the messages have the same content. Comparison
+ * stops at the first difference. */
+extern FudgeStatus content_isEqual ( int * equal, FudgeMsg x, FudgeMsg y );
+
+/* Sets hash to a 64-bit FNV-1a hash of the message's content; messages
+ * with equal content have equal hashes */
+extern FudgeStatus content_hash ( uint64_t * hash, FudgeMsg message );
+
+#endif
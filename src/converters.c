@@ -15,25 +15,25 @@
  */
 #include "converters.h"
 #include "message.h"
+#include "timezone.h"
 #include <datetime.h>
 #include <fudge/datetime.h>
 
-static PyObject * s_timezonemodule = 0,
-                * s_timezonetype = 0;
+static PyObject * s_arraytype = 0;
 
 int fudgepyc_initialiseConverters ( PyObject * module )
 {
-    if ( ! s_timezonemodule &&
-         ! ( s_timezonemodule = PyImport_ImportModule ( "fudgepyc.timezone" ) ) )
-        return -1;
-    if ( ! s_timezonetype &&
-         ! ( s_timezonetype = PyObject_GetAttrString ( s_timezonemodule,
-                                                       "Timezone" ) ) )
+    /* The array module does not implement the new buffer interface, so
+       array.array instances must be recognised by type */
+    if ( ! s_arraytype )
     {
-        exception_raise_any ( PyExc_ImportError,
-                              "Could not find \"Timezone\" class in "
-                              "fudgepyc/timezone module" );
-        return -1;
+        PyObject * arraymodule = PyImport_ImportModule ( "array" );
+        if ( ! arraymodule )
+            return -1;
+        s_arraytype = PyObject_GetAttrString ( arraymodule, "ArrayType" );
+        Py_DECREF( arraymodule );
+        if ( ! s_arraytype )
+            return -1;
     }
 
     PyDateTime_IMPORT;
@@ -150,31 +150,17 @@ int fudgepyc_convertPythonToString ( FudgeString * target, PyObject * source )
     }
     else if ( PyUnicode_Check ( source ) )
     {
-        /* The Python docs specify that the internal representation of Unicode
-           objects is either UCS2 or UCS4 */
-        switch ( sizeof ( Py_UNICODE ) )
-        {
-            case 2:
-                status = FudgeString_createFromUTF16 (
-                             target,
-                             ( fudge_byte * ) PyUnicode_AS_DATA ( source ),
-                             PyUnicode_GET_DATA_SIZE ( source ) );
-                break;
-
-            case 4:
-                status = FudgeString_createFromUTF32 (
-                             target,
-                             ( fudge_byte * ) PyUnicode_AS_DATA ( source ),
-                             PyUnicode_GET_DATA_SIZE ( source ) );
-                break;
-
-            default:
-                exception_raise_any ( PyExc_RuntimeError,
-                                     "Cannot encode Python string; Python "
-                                     "interpreter not using UCS2 or UCS4 for"
-                                     "internal unicode encoding" );
-                return -1;
-        }
+        /* Fudge strings are UTF-8, so encode straight to that rather than
+           transcoding the interpreter's internal UCS2/UCS4 representation */
+        PyObject * encoded;
+
+        if ( ! ( encoded = PyUnicode_AsUTF8String ( source ) ) )
+            return -1;
+        status = FudgeString_createFromUTF8 (
+                     target,
+                     ( const fudge_byte * ) PyString_AS_STRING ( encoded ),
+                     PyString_GET_SIZE ( encoded ) );
+        Py_DECREF( encoded );
         return exception_raiseOnError ( status );
     }
     else
@@ -186,25 +172,48 @@ int fudgepyc_convertPythonToString ( FudgeString * target, PyObject * source )
     }
 }
 
-static int fudgepyc_convertAttrToInt ( int * target,
-                                       PyObject * obj,
-                                       const char * attr )
+#define CONVERTER_NANOS_PER_SECOND  1000000000LL
+#define CONVERTER_SECONDS_PER_DAY   86400LL
+
+/* Days between 1970-01-01 and a proleptic Gregorian date; month and day
+ * are 1 based */
+static PY_LONG_LONG fudgepyc_daysFromCivil ( PY_LONG_LONG year, int month, int day )
 {
-    PyObject * attrobj = PyObject_GetAttrString ( obj, attr );
-    if ( attrobj )
-    {
-        *target = ( int ) PyInt_AsLong ( attrobj );
-        Py_DECREF( attrobj );
-        return 0;
-    }
-    else
-        return -1;
+    PY_LONG_LONG era, yoe, doy, doe;
+
+    year -= month <= 2;
+    era = ( year >= 0 ? year : year - 399 ) / 400;
+    yoe = year - era * 400;
+    doy = ( 153 * ( month + ( month > 2 ? -3 : 9 ) ) + 2 ) / 5 + day - 1;
+    doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+/* The inverse of fudgepyc_daysFromCivil */
+static void fudgepyc_civilFromDays ( PY_LONG_LONG * year, int * month, int * day, PY_LONG_LONG days )
+{
+    PY_LONG_LONG era, doe, yoe, doy, mp;
+
+    days += 719468;
+    era = ( days >= 0 ? days : days - 146096 ) / 146097;
+    doe = days - era * 146097;
+    yoe = ( doe - doe / 1460 + doe / 36524 - doe / 146096 ) / 365;
+    doy = doe - ( 365 * yoe + yoe / 4 - yoe / 100 );
+    mp = ( 5 * doy + 2 ) / 153;
+    *day = ( int ) ( doy - ( 153 * mp + 2 ) / 5 + 1 );
+    *month = ( int ) ( mp < 10 ? mp + 3 : mp - 9 );
+    *year = yoe + era * 400 + ( *month <= 2 );
+}
+
+/* Floor division, so that times before the epoch round down */
+static PY_LONG_LONG fudgepyc_floorDivide ( PY_LONG_LONG value, PY_LONG_LONG divisor )
+{
+    return value / divisor - ( value % divisor < 0 );
 }
 
 int fudgepyc_convertPythonToDate ( FudgeDate * target, PyObject * source )
 {
     FudgeStatus status;
-    int year, month, day;
 
     if ( ! ( PyDate_Check ( source ) || PyDateTime_Check ( source ) ) )
     {
@@ -214,18 +223,16 @@ int fudgepyc_convertPythonToDate ( FudgeDate * target, PyObject * source )
         return -1;
     }
 
-    if ( fudgepyc_convertAttrToInt ( &year, source, "year" ) ||
-         fudgepyc_convertAttrToInt ( &month, source, "month" ) ||
-         fudgepyc_convertAttrToInt ( &day, source, "day" ) )
-        return -1;
-
-    status = FudgeDate_initialise ( target, year, month, day );
+    status = FudgeDate_initialise ( target,
+                                    PyDateTime_GET_YEAR( source ),
+                                    PyDateTime_GET_MONTH( source ),
+                                    PyDateTime_GET_DAY( source ) );
     return exception_raiseOnError ( status );
 }
 
 static int fudgepyc_convertUtcOffset ( int * target, PyObject * obj )
 {
-    int days, seconds, microseconds;
+    int seconds;
 
     if ( ! PyDelta_Check ( obj ) )
     {
@@ -235,14 +242,10 @@ static int fudgepyc_convertUtcOffset ( int * target, PyObject * obj )
         return -1;
     }
 
-    if ( fudgepyc_convertAttrToInt ( &days, obj, "days" ) ||
-         fudgepyc_convertAttrToInt ( &seconds, obj, "seconds" ) ||
-         fudgepyc_convertAttrToInt ( &microseconds, obj, "microseconds" ) )
-        return -1;
-
-    seconds += days * 86400;
+    seconds = ( ( PyDateTime_Delta * ) obj )->seconds +
+              ( ( PyDateTime_Delta * ) obj )->days * 86400;
 
-    if ( seconds % 60 || microseconds )
+    if ( seconds % 60 || ( ( PyDateTime_Delta * ) obj )->microseconds )
     {
         exception_raise_any ( PyExc_ValueError,
                               "The maximum resolution for datetime.tzinfo "
@@ -255,13 +258,61 @@ static int fudgepyc_convertUtcOffset ( int * target, PyObject * obj )
     return 0;
 }
 
+/* Sets offset to the source's UTC offset in fifteen minute intervals and
+ * hastz to true, or hastz to false if the source is naive. The tzinfo is
+ * only called if it is not one of the library's own Timezones. */
+static int fudgepyc_convertTzInfo ( int * offset, int * hastz, PyObject * source )
+{
+    PyObject * tzinfo = 0, * utcoffset;
+    int result = 0;
+
+    if ( ( ( _PyDateTime_BaseTZInfo * ) source )->hastzinfo )
+        tzinfo = PyDateTime_Check ( source ) ? ( ( PyDateTime_DateTime * ) source )->tzinfo
+                                             : ( ( PyDateTime_Time * ) source )->tzinfo;
+
+    *offset = 0;
+    if ( ! tzinfo || tzinfo == Py_None )
+    {
+        *hastz = 0;
+        return 0;
+    }
+
+    if ( Py_TYPE( tzinfo ) == &TimezoneType &&
+         abs ( ( ( Timezone * ) tzinfo )->quarters ) <= TIMEZONE_MAX_QUARTERS )
+    {
+        *offset = ( ( Timezone * ) tzinfo )->quarters;
+        *hastz = 1;
+        return 0;
+    }
+
+    if ( ! ( utcoffset = PyObject_CallMethod ( source, "utcoffset", "" ) ) )
+        return -1;
+    if ( ( *hastz = ( utcoffset != Py_None ) ) )
+        result = fudgepyc_convertUtcOffset ( offset, utcoffset );
+    Py_DECREF( utcoffset );
+    return result;
+}
+
 int fudgepyc_convertPythonToTime ( FudgeTime * target, PyObject * source )
 {
     FudgeStatus status;
-    int hour, minute, second, microsecond, offset = 0, result, hastz;
-    PyObject * utcoffset;
+    int seconds, microsecond, offset, hastz;
 
-    if ( ! ( PyTime_Check ( source ) || PyDateTime_Check ( source ) ) )
+    if ( PyDateTime_Check ( source ) )
+    {
+        seconds = PyDateTime_DATE_GET_HOUR( source ) * 3600 +
+                  PyDateTime_DATE_GET_MINUTE( source ) * 60 +
+                  PyDateTime_DATE_GET_SECOND( source );
+        microsecond = PyDateTime_DATE_GET_MICROSECOND( source );
+    }
+    else if ( PyTime_Check ( source ) )
+    {
+        seconds = PyDateTime_TIME_GET_HOUR( source ) * 3600 +
+                  PyDateTime_TIME_GET_MINUTE( source ) * 60 +
+                  PyDateTime_TIME_GET_SECOND( source );
+        microsecond = PyDateTime_TIME_GET_MICROSECOND( source );
+    }
+    else
     {
         exception_raise_any ( PyExc_TypeError,
                               "Only datetime.time and datetime.datetime "
@@ -269,31 +320,18 @@ int fudgepyc_convertPythonToTime ( FudgeTime * target, PyObject * source )
         return -1;
     }
 
-    if ( ! ( utcoffset = PyObject_CallMethod ( source, "utcoffset", "" ) ) )
-        return -1;
-    if ( ( hastz = ( utcoffset != Py_None ) ) )
-        result = fudgepyc_convertUtcOffset ( &offset, utcoffset );
-    else
-        result = offset = 0;
-    Py_DECREF( utcoffset );
-    if ( result )
-        return -1;
-
-    if ( fudgepyc_convertAttrToInt ( &hour, source, "hour" ) ||
-         fudgepyc_convertAttrToInt ( &minute, source, "minute" ) ||
-         fudgepyc_convertAttrToInt ( &second, source, "second" ) ||
-         fudgepyc_convertAttrToInt ( &microsecond, source, "microsecond" ) )
+    if ( fudgepyc_convertTzInfo ( &offset, &hastz, source ) )
         return -1;
 
     if ( hastz )
         status = FudgeTime_initialiseWithTimezone ( target,
-                                                    second + minute * 60 + hour * 3600,
+                                                    seconds,
                                                     microsecond * 1000,
                                                     FUDGE_DATETIME_PRECISION_MICROSECOND,
                                                     offset );
     else
         status = FudgeTime_initialise ( target,
-                                        second + minute * 60 + hour * 3600,
+                                        seconds,
                                         microsecond * 1000,
                                         FUDGE_DATETIME_PRECISION_MICROSECOND );
     return exception_raiseOnError ( status );
@@ -413,6 +451,45 @@ int fudgepyc_convertPythonToDateTimeEx ( FudgeDateTime * target,
                                             offsetobj );
 }
 
+int fudgepyc_convertPythonToDateTimeFromEpoch ( FudgeDateTime * target,
+                                                unsigned int precision,
+                                                PyObject * nanosobj,
+                                                PyObject * offsetobj )
+{
+    FudgeStatus status;
+    fudge_i64 nanos;
+    PY_LONG_LONG seconds, days, year;
+    int month, day, offset = 0;
+
+    if ( fudgepyc_convertPythonToI64 ( &nanos, nanosobj ) )
+        return -1;
+    if ( offsetobj && fudgepyc_convertToBoundedInt ( &offset, offsetobj, -127, 127 ) )
+        return -1;
+
+    /* The epoch is in UTC, the Fudge fields hold the local time */
+    seconds = fudgepyc_floorDivide ( nanos, CONVERTER_NANOS_PER_SECOND ) + offset * 900;
+    days = fudgepyc_floorDivide ( seconds, CONVERTER_SECONDS_PER_DAY );
+    fudgepyc_civilFromDays ( &year, &month, &day, days );
+
+    if ( ( status = FudgeDate_initialise ( &target->date, ( fudge_i32 ) year, month, day ) ) != FUDGE_OK )
+        return exception_raiseOnError ( status );
+
+    seconds -= days * CONVERTER_SECONDS_PER_DAY;
+    nanos -= fudgepyc_floorDivide ( nanos, CONVERTER_NANOS_PER_SECOND ) * CONVERTER_NANOS_PER_SECOND;
+    if ( offsetobj )
+        status = FudgeTime_initialiseWithTimezone ( &target->time,
+                                                    ( uint32_t ) seconds,
+                                                    ( uint32_t ) nanos,
+                                                    precision,
+                                                    offset );
+    else
+        status = FudgeTime_initialise ( &target->time,
+                                        ( uint32_t ) seconds,
+                                        ( uint32_t ) nanos,
+                                        precision );
+    return exception_raiseOnError ( status );
+}
+
 #define CONVERT_PYTHON_SEQ_TO_BLOCK( TYPENAME, NAME, CTYPE )                \
 int fudgepyc_convertPythonSeqTo ## TYPENAME ## Block ( CTYPE * target,      \
                                                        fudge_i32 size,      \
@@ -524,20 +601,343 @@ int fudgepyc_convertPythonToByteArray ( fudge_byte * * target,
     return 0;
 }
 
-#define CONVERT_PYTHON_TO_VAR_ARRAY( TYPENAME, CTYPE )                      \
+int fudgepyc_getPythonByteArray ( ConverterArray * array, PyObject * source )
+{
+    fudge_byte * copy;
+    Py_ssize_t size = -1;
+
+    array->copy = 0;
+    array->buffer.hasview = 0;
+
+    /* String and Unicode data is used in place */
+    if ( PyString_Check ( source ) )
+    {
+        array->data = PyString_AS_STRING ( source );
+        size = PyString_GET_SIZE ( source );
+    }
+    else if ( PyUnicode_Check ( source ) )
+    {
+        array->data = PyUnicode_AS_DATA ( source );
+        size = PyUnicode_GET_DATA_SIZE ( source );
+    }
+
+    if ( size > INT32_MAX )
+    {
+        exception_raise_any ( PyExc_OverflowError,
+                              "Array of %zd elements is too large for a field",
+                              size );
+        return -1;
+    }
+    if ( size >= 0 )
+    {
+        array->size = ( fudge_i32 ) size;
+        return 0;
+    }
+
+    if ( fudgepyc_convertPythonToByteArray ( &copy, &array->size, source ) )
+        return -1;
+    array->data = array->copy = copy;
+    return 0;
+}
+
+/* Sets kind from a struct module format string, returning -1 if it is not
+ * a single native numeric element */
+static int fudgepyc_parseBufferFormat ( char * kind, const char * format )
+{
+    static const int one = 1;
+    const int littleendian = * ( const char * ) &one;
+
+    switch ( *format )
+    {
+        case '@': case '=':
+            ++format;
+            break;
+        case '<':
+            if ( ! littleendian )
+                return -1;
+            ++format;
+            break;
+        case '>': case '!':
+            if ( littleendian )
+                return -1;
+            ++format;
+            break;
+    }
+
+    if ( ! format [ 0 ] || format [ 1 ] )
+        return -1;
+
+    switch ( *format )
+    {
+        case 'b': case 'h': case 'i': case 'l': case 'q':
+            *kind = 'i';
+            return 0;
+        case 'B': case 'H': case 'I': case 'L': case 'Q':
+            *kind = 'u';
+            return 0;
+        case 'f': case 'd':
+            *kind = 'f';
+            return 0;
+        default:
+            return -1;
+    }
+}
+
+/* Returns 1 and fills buffer if source exposes a contiguous block of
+ * native numbers, 0 if the sequence conversion should be used instead,
+ * or -1 with an exception set on failure. The caller must release the
+ * buffer with fudgepyc_releaseBuffer. */
+static int fudgepyc_getBuffer ( ConverterBuffer * buffer, PyObject * source )
+{
+    PyObject * typecode, * itemsize;
+    Py_ssize_t numbytes;
+    int result = 0;
+
+    buffer->hasview = 0;
+
+    /* Strings are sequences of characters, not of numbers */
+    if ( PyString_Check ( source ) || PyUnicode_Check ( source ) )
+        return 0;
+
+    if ( PyObject_CheckBuffer ( source ) )
+    {
+        /* Objects that cannot supply a contiguous view are converted as
+           sequences instead */
+        if ( PyObject_GetBuffer ( source,
+                                  &buffer->view,
+                                  PyBUF_C_CONTIGUOUS | PyBUF_FORMAT ) )
+        {
+            if ( ! PyErr_ExceptionMatches ( PyExc_BufferError ) &&
+                 ! PyErr_ExceptionMatches ( PyExc_TypeError ) )
+                return -1;
+            PyErr_Clear ( );
+            return 0;
+        }
+        buffer->hasview = 1;
+
+        if ( fudgepyc_parseBufferFormat ( &buffer->kind,
+                                          buffer->view.format ? buffer->view.format : "B" ) ||
+             buffer->view.itemsize <= 0 )
+            return 0;
+
+        buffer->data = buffer->view.buf;
+        buffer->itemsize = buffer->view.itemsize;
+        buffer->count = buffer->view.len / buffer->view.itemsize;
+        return 1;
+    }
+
+    if ( ! s_arraytype || ! PyObject_TypeCheck ( source, ( PyTypeObject * ) s_arraytype ) )
+        return 0;
+
+    if ( ! ( typecode = PyObject_GetAttrString ( source, "typecode" ) ) )
+        return -1;
+    if ( ! ( itemsize = PyObject_GetAttrString ( source, "itemsize" ) ) )
+        goto clear_typecode_and_return;
+
+    if ( PyString_Check ( typecode ) &&
+         ! fudgepyc_parseBufferFormat ( &buffer->kind, PyString_AS_STRING ( typecode ) ) )
+    {
+        if ( ( buffer->itemsize = PyInt_AsSsize_t ( itemsize ) ) == -1 ||
+             PyObject_AsReadBuffer ( source, &buffer->data, &numbytes ) )
+            result = -1;
+        else
+        {
+            buffer->count = numbytes / buffer->itemsize;
+            result = 1;
+        }
+    }
+
+    Py_DECREF( itemsize );
+clear_typecode_and_return:
+    Py_DECREF( typecode );
+    return result ? result : ( PyErr_Occurred ( ) ? -1 : 0 );
+}
+
+static void fudgepyc_releaseBuffer ( ConverterBuffer * buffer )
+{
+    if ( buffer->hasview )
+        PyBuffer_Release ( &buffer->view );
+}
+
+#define CONVERTER_BUFFER_KEY( KIND, ITEMSIZE ) ( ( ( KIND ) << 8 ) | ( int ) ( ITEMSIZE ) )
+
+/* Widens or narrows each element of a buffer of STYPE. Integer targets
+ * are range checked once, against the buffer's minimum and maximum; the
+ * loops are kept free of branches so the compiler can vectorise them. */
+#define CONVERT_BUFFER_ELEMENTS( STYPE, CTYPE, NAME, LOW, HIGH, ISINTEGER )  \
+{                                                                           \
+    const STYPE * elements = ( const STYPE * ) buffer->data;                \
+    STYPE minimum = 0, maximum = 0;                                         \
+                                                                            \
+    if ( ISINTEGER && buffer->count )                                       \
+    {                                                                       \
+        minimum = maximum = elements [ 0 ];                                 \
+        for ( index = 1; index < buffer->count; ++index )                   \
+        {                                                                   \
+            minimum = elements [ index ] < minimum ? elements [ index ]     \
+                                                   : minimum;               \
+            maximum = elements [ index ] > maximum ? elements [ index ]     \
+                                                   : maximum;               \
+        }                                                                   \
+        if ( ( minimum < 0 && ( PY_LONG_LONG ) minimum < LOW ) ||           \
+             ( maximum > 0 && ( unsigned PY_LONG_LONG ) maximum >           \
+                              ( unsigned PY_LONG_LONG ) HIGH ) )            \
+        {                                                                   \
+            exception_raise_any ( PyExc_OverflowError,                      \
+                                  "Cannot use array as %s array, values "   \
+                                  "out of range", NAME );                   \
+            return -1;                                                      \
+        }                                                                   \
+    }                                                                       \
+                                                                            \
+    for ( index = 0; index < buffer->count; ++index )                       \
+        target [ index ] = ( CTYPE ) elements [ index ];                    \
+    return 0;                                                               \
+}
+
+/* Fills target from a buffer. Returns 0 on success, 1 if the buffer's
+ * element type cannot be converted without the per-element sequence
+ * semantics (floating point to integer), or -1 with an exception set. */
+#define CONVERT_BUFFER_TO_BLOCK( TYPENAME, NAME, CTYPE, KIND, LOW, HIGH )   \
+static int fudgepyc_convertBufferTo ## TYPENAME ## Block (                  \
+               CTYPE * target,                                              \
+               const ConverterBuffer * buffer )                             \
+{                                                                           \
+    const int isinteger = KIND != 'f';                                      \
+    Py_ssize_t index;                                                       \
+                                                                            \
+    if ( isinteger && buffer->kind == 'f' )                                 \
+        return 1;                                                           \
+                                                                            \
+    switch ( CONVERTER_BUFFER_KEY( buffer->kind, buffer->itemsize ) )      \
+    {                                                                       \
+        case CONVERTER_BUFFER_KEY( 'i', 1 ):                                \
+            CONVERT_BUFFER_ELEMENTS( int8_t,   CTYPE, NAME, LOW, HIGH, isinteger ) \
+        case CONVERTER_BUFFER_KEY( 'i', 2 ):                                \
+            CONVERT_BUFFER_ELEMENTS( int16_t,  CTYPE, NAME, LOW, HIGH, isinteger ) \
+        case CONVERTER_BUFFER_KEY( 'i', 4 ):                                \
+            CONVERT_BUFFER_ELEMENTS( int32_t,  CTYPE, NAME, LOW, HIGH, isinteger ) \
+        case CONVERTER_BUFFER_KEY( 'i', 8 ):                                \
+            CONVERT_BUFFER_ELEMENTS( int64_t,  CTYPE, NAME, LOW, HIGH, isinteger ) \
+        case CONVERTER_BUFFER_KEY( 'u', 1 ):                                \
+            CONVERT_BUFFER_ELEMENTS( uint8_t,  CTYPE, NAME, LOW, HIGH, isinteger ) \
+        case CONVERTER_BUFFER_KEY( 'u', 2 ):                                \
+            CONVERT_BUFFER_ELEMENTS( uint16_t, CTYPE, NAME, LOW, HIGH, isinteger ) \
+        case CONVERTER_BUFFER_KEY( 'u', 4 ):                                \
+            CONVERT_BUFFER_ELEMENTS( uint32_t, CTYPE, NAME, LOW, HIGH, isinteger ) \
+        case CONVERTER_BUFFER_KEY( 'u', 8 ):                                \
+            CONVERT_BUFFER_ELEMENTS( uint64_t, CTYPE, NAME, LOW, HIGH, isinteger ) \
+        case CONVERTER_BUFFER_KEY( 'f', 4 ):                                \
+            CONVERT_BUFFER_ELEMENTS( float,    CTYPE, NAME, LOW, HIGH, 0 ) \
+        case CONVERTER_BUFFER_KEY( 'f', 8 ):                                \
+            CONVERT_BUFFER_ELEMENTS( double,   CTYPE, NAME, LOW, HIGH, 0 ) \
+        default:                                                            \
+            return 1;                                                       \
+    }                                                                       \
+}
+
+CONVERT_BUFFER_TO_BLOCK( I16, "short",  fudge_i16, 'i', INT16_MIN, INT16_MAX )
+CONVERT_BUFFER_TO_BLOCK( I32, "int",    fudge_i32, 'i', INT32_MIN, INT32_MAX )
+CONVERT_BUFFER_TO_BLOCK( I64, "long",   fudge_i64, 'i', INT64_MIN, INT64_MAX )
+CONVERT_BUFFER_TO_BLOCK( F32, "float",  fudge_f32, 'f', 0, 0 )
+CONVERT_BUFFER_TO_BLOCK( F64, "double", fudge_f64, 'f', 0, 0 )
+
+/* Objects exposing a buffer of numbers (array.array, bytearray, numpy
+ * arrays, array Fields) are used in place if their elements are already
+ * of the target type, or converted in bulk if not; anything else is
+ * converted an element at a time as a sequence */
+#define CONVERT_PYTHON_TO_VAR_ARRAY( TYPENAME, CTYPE, KIND )                \
+int fudgepyc_getPython ## TYPENAME ## Array ( ConverterArray * array,       \
+                                              PyObject * source )           \
+{                                                                           \
+    ConverterBuffer * buffer = &array->buffer;                              \
+    CTYPE * copy;                                                           \
+    int result;                                                             \
+                                                                            \
+    array->copy = 0;                                                        \
+                                                                            \
+    if ( ( result = fudgepyc_getBuffer ( buffer, source ) ) == 1 )          \
+    {                                                                       \
+        if ( buffer->count > INT32_MAX )                                    \
+        {                                                                   \
+            exception_raise_any ( PyExc_OverflowError,                      \
+                                  "Array of %zd elements is too large for " \
+                                  "a field", buffer->count );               \
+            result = -1;                                                    \
+        }                                                                   \
+        else if ( buffer->kind == KIND &&                                   \
+                  buffer->itemsize == sizeof ( CTYPE ) )                    \
+        {                                                                   \
+            /* Borrowed: the view is held until the array is released */    \
+            array->data = buffer->data;                                     \
+            array->size = ( fudge_i32 ) buffer->count;                      \
+            return 0;                                                       \
+        }                                                                   \
+        else if ( ! ( copy = ( CTYPE * ) PyMem_Malloc (                     \
+                                 sizeof ( CTYPE ) * ( buffer->count + 1 ) ) ) ) \
+        {                                                                   \
+            PyErr_NoMemory ( );                                             \
+            result = -1;                                                    \
+        }                                                                   \
+        else if ( ! ( result = fudgepyc_convertBufferTo ## TYPENAME ## Block (  \
+                                   copy, buffer ) ) )                       \
+        {                                                                   \
+            array->data = array->copy = copy;                               \
+            array->size = ( fudge_i32 ) buffer->count;                      \
+            fudgepyc_releaseBuffer ( buffer );                              \
+            buffer->hasview = 0;                                            \
+            return 0;                                                       \
+        }                                                                   \
+        else                                                                \
+            PyMem_Free ( copy );                                            \
+    }                                                                       \
+    fudgepyc_releaseBuffer ( buffer );                                      \
+    buffer->hasview = 0;                                                    \
+                                                                            \
+    if ( result == -1 ||                                                    \
+         fudgepyc_convertPythonSeqTo ## TYPENAME ## Array (                 \
+             &copy, &array->size, source ) )                                \
+        return -1;                                                          \
+    array->data = array->copy = copy;                                       \
+    return 0;                                                               \
+}                                                                           \
+                                                                            \
 int fudgepyc_convertPythonTo ## TYPENAME ## Array ( CTYPE * * target,       \
                                                     fudge_i32 * size,       \
                                                     PyObject * source )     \
 {                                                                           \
-    return fudgepyc_convertPythonSeqTo ## TYPENAME ## Array (               \
-               target, size, source );                                      \
+    ConverterArray array;                                                   \
+                                                                            \
+    if ( fudgepyc_getPython ## TYPENAME ## Array ( &array, source ) )       \
+        return -1;                                                          \
+                                                                            \
+    *size = array.size;                                                     \
+    if ( array.copy )                                                       \
+    {                                                                       \
+        *target = ( CTYPE * ) array.copy;                                   \
+        array.copy = 0;                                                     \
+    }                                                                       \
+    else if ( ( *target = ( CTYPE * ) PyMem_Malloc (                        \
+                              sizeof ( CTYPE ) * ( *size + 1 ) ) ) )        \
+        memcpy ( *target, array.data, sizeof ( CTYPE ) * *size );           \
+    else                                                                    \
+        PyErr_NoMemory ( );                                                 \
+                                                                            \
+    fudgepyc_releaseArray ( &array );                                       \
+    return *target ? 0 : -1;                                                \
 }
 
-CONVERT_PYTHON_TO_VAR_ARRAY( I16, fudge_i16 );
-CONVERT_PYTHON_TO_VAR_ARRAY( I32, fudge_i32 );
-CONVERT_PYTHON_TO_VAR_ARRAY( I64, fudge_i64 );
-CONVERT_PYTHON_TO_VAR_ARRAY( F32, fudge_f32 );
-CONVERT_PYTHON_TO_VAR_ARRAY( F64, fudge_f64 );
+CONVERT_PYTHON_TO_VAR_ARRAY( I16, fudge_i16, 'i' );
+CONVERT_PYTHON_TO_VAR_ARRAY( I32, fudge_i32, 'i' );
+CONVERT_PYTHON_TO_VAR_ARRAY( I64, fudge_i64, 'i' );
+CONVERT_PYTHON_TO_VAR_ARRAY( F32, fudge_f32, 'f' );
+CONVERT_PYTHON_TO_VAR_ARRAY( F64, fudge_f64, 'f' );
+
+void fudgepyc_releaseArray ( ConverterArray * array )
+{
+    fudgepyc_releaseBuffer ( &array->buffer );
+    PyMem_Free ( array->copy );
+}
 
 int fudgepyc_convertPythonToFixedByteArray ( fudge_byte * target,
                                              fudge_i32 size,
@@ -622,37 +1022,20 @@ PyObject * fudgepyc_convertF64ToPython ( fudge_f64 source )
 
 PyObject * fudgepyc_convertStringToPython ( FudgeString source )
 {
-    PyObject * target = 0;
-    fudge_byte * buffer;
-    size_t written, bufsize;
-
-    bufsize = FudgeString_getSize ( source ) * sizeof ( Py_UNICODE );
-    if ( ! ( buffer = ( fudge_byte * ) PyMem_Malloc ( bufsize ) ) )
-        return 0;
-
-    /* See comment in fudgepyc_convertPythonToString for explanation */
-    switch ( sizeof ( Py_UNICODE ) )
-    {
-        case 2:
-            written = FudgeString_copyToUTF16 ( buffer, bufsize, source );
-            break;
-
-        case 4:
-            written = FudgeString_copyToUTF32 ( buffer, bufsize, source );
-            break;
+    return PyUnicode_DecodeUTF8 ( FudgeString_getData ( source ),
+                                  FudgeString_getSize ( source ),
+                                  "strict" );
+}
 
-        default:
-            exception_raise_any ( PyExc_RuntimeError,
-                                  "Cannot decode Fudge string; Python "
-                                  "interpreter not using UCS2 or UCS4 for"
-                                  "internal unicode encoding" );
-            return 0;
-    }
+PyObject * fudgepyc_convertStringToPythonAscii ( FudgeString source )
+{
+    const char * data = FudgeString_getData ( source );
+    size_t index, size = FudgeString_getSize ( source );
 
-    target = PyUnicode_FromUnicode ( ( Py_UNICODE * ) buffer,
-                                     written / sizeof ( Py_UNICODE ) );
-    PyMem_Free ( buffer );
-    return target;
+    for ( index = 0; index < size; ++index )
+        if ( ( unsigned char ) data [ index ] & 0x80 )
+            return PyUnicode_DecodeUTF8 ( data, size, "strict" );
+    return PyString_FromStringAndSize ( data, size );
 }
 
 typedef struct
@@ -676,14 +1059,7 @@ static int fudgepyc_convertTimeToPythonDateTime ( PythonDateTime * target,
 {
     if ( source->hasTimezone )
     {
-        PyObject * args = Py_BuildValue ( "(i)", source->timezoneOffset );
-        if ( ! args )
-            return -1;
-
-        target->tzinfo = PyObject_CallObject ( s_timezonetype, args );
-        Py_DECREF( args );
-
-        if ( ! target->tzinfo )
+        if ( ! ( target->tzinfo = Timezone_fromQuarters ( source->timezoneOffset ) ) )
             return -1;
     }
     else
@@ -696,11 +1072,52 @@ static int fudgepyc_convertTimeToPythonDateTime ( PythonDateTime * target,
     return 0;
 }
 
+/* The datetime C-API constructors do not range check their arguments, so
+ * values from the wire are checked here, as the Python constructors would.
+ * Returns 0 if valid, -1 with a ValueError set if not. */
+static int fudgepyc_checkPythonDateTime ( const PythonDateTime * source,
+                                          int hasdate,
+                                          int hastime )
+{
+    static const int monthdays [] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+    const char * error = 0;
+    int leap;
+
+    if ( hasdate )
+    {
+        leap = source->years % 4 == 0 && ( source->years % 100 != 0 || source->years % 400 == 0 );
+        if ( source->years < 1 || source->years > 9999 )
+            error = "year is out of range";
+        else if ( source->months < 1 || source->months > 12 )
+            error = "month must be in 1..12";
+        else if ( source->days < 1 ||
+                  source->days > monthdays [ source->months - 1 ] + ( leap && source->months == 2 ) )
+            error = "day is out of range for month";
+    }
+    if ( hastime && ! error )
+    {
+        if ( source->hours < 0 || source->hours > 23 )
+            error = "hour must be in 0..23";
+        else if ( source->minutes < 0 || source->minutes > 59 )
+            error = "minute must be in 0..59";
+        else if ( source->seconds < 0 || source->seconds > 59 )
+            error = "second must be in 0..59";
+        else if ( source->microseconds < 0 || source->microseconds > 999999 )
+            error = "microsecond must be in 0..999999";
+    }
+
+    if ( ! error )
+        return 0;
+    exception_raise_any ( PyExc_ValueError, "%s", error );
+    return -1;
+}
+
 PyObject * fudgepyc_convertDateToPython ( FudgeDate * source )
 {
     PythonDateTime pdt;
 
-    if ( fudgepyc_convertDateToPythonDateTime ( &pdt, source ) )
+    if ( fudgepyc_convertDateToPythonDateTime ( &pdt, source ) ||
+         fudgepyc_checkPythonDateTime ( &pdt, 1, 0 ) )
         return 0;
 
     return PyDate_FromDate ( pdt.years, pdt.months, pdt.days );
@@ -709,53 +1126,43 @@ PyObject * fudgepyc_convertDateToPython ( FudgeDate * source )
 PyObject * fudgepyc_convertTimeToPython ( FudgeTime * source )
 {
     PythonDateTime pdt;
-    PyObject * target = 0,
-             * args;
+    PyObject * target = 0;
 
     if ( fudgepyc_convertTimeToPythonDateTime ( &pdt, source ) )
         return 0;
 
-    args = Py_BuildValue ( "iiiiO", pdt.hours,
-                                    pdt.minutes,
-                                    pdt.seconds,
-                                    pdt.microseconds,
-                                    pdt.tzinfo );
+    if ( ! fudgepyc_checkPythonDateTime ( &pdt, 0, 1 ) )
+        target = PyDateTimeAPI->Time_FromTime ( pdt.hours,
+                                                pdt.minutes,
+                                                pdt.seconds,
+                                                pdt.microseconds,
+                                                pdt.tzinfo,
+                                                PyDateTimeAPI->TimeType );
     Py_DECREF( pdt.tzinfo );
-    if ( ! args )
-        return 0;
-
-    target = PyObject_CallObject ( ( PyObject * ) PyDateTimeAPI->TimeType,
-                                    args );
-    Py_DECREF( args );
     return target;
 }
 
 PyObject * fudgepyc_convertDateTimeToPython ( FudgeDateTime * source )
 {
     PythonDateTime pdt;
-    PyObject * target = 0,
-             * args;
+    PyObject * target = 0;
 
     if ( fudgepyc_convertDateToPythonDateTime ( &pdt, &source->date ) )
         return 0;
     if ( fudgepyc_convertTimeToPythonDateTime ( &pdt, &source->time ) )
         return 0;
 
-    args = Py_BuildValue ( "iiiiiiiO", pdt.years,
-                                       pdt.months,
-                                       pdt.days,
-                                       pdt.hours,
-                                       pdt.minutes,
-                                       pdt.seconds,
-                                       pdt.microseconds,
-                                       pdt.tzinfo );
+    if ( ! fudgepyc_checkPythonDateTime ( &pdt, 1, 1 ) )
+        target = PyDateTimeAPI->DateTime_FromDateAndTime ( pdt.years,
+                                                           pdt.months,
+                                                           pdt.days,
+                                                           pdt.hours,
+                                                           pdt.minutes,
+                                                           pdt.seconds,
+                                                           pdt.microseconds,
+                                                           pdt.tzinfo,
+                                                           PyDateTimeAPI->DateTimeType );
     Py_DECREF( pdt.tzinfo );
-    if ( ! args )
-        return 0;
-
-    target = PyObject_CallObject ( ( PyObject * ) PyDateTimeAPI->DateTimeType,
-                                    args );
-    Py_DECREF( args );
     return target;
 }
 
@@ -813,6 +1220,53 @@ PyObject * fudgepyc_convertDateTimeToPythonEx ( FudgeDateTime * source )
                                         offset );
 }
 
+/* Returns seconds as a Python long of nanoseconds, or raises OverflowError
+ * if that does not fit in 64 bits */
+static PyObject * fudgepyc_convertSecondsToPythonNanos ( PY_LONG_LONG seconds,
+                                                         fudge_i64 nanos )
+{
+    const PY_LONG_LONG limit = ( INT64_MAX - CONVERTER_NANOS_PER_SECOND ) / CONVERTER_NANOS_PER_SECOND;
+
+    if ( seconds > limit || seconds < -limit )
+    {
+        exception_raise_any ( PyExc_OverflowError,
+                              "Cannot represent date/time as 64-bit "
+                              "nanoseconds, out of range" );
+        return 0;
+    }
+    return PyLong_FromLongLong ( seconds * CONVERTER_NANOS_PER_SECOND + nanos );
+}
+
+static PY_LONG_LONG fudgepyc_getEpochDays ( FudgeDate * source )
+{
+    return fudgepyc_daysFromCivil ( source->year,
+                                    source->month > 0 ? source->month : 1,
+                                    source->day > 0 ? source->day : 1 );
+}
+
+PyObject * fudgepyc_convertDateToPythonEpoch ( FudgeDate * source )
+{
+    return fudgepyc_convertSecondsToPythonNanos (
+               fudgepyc_getEpochDays ( source ) * CONVERTER_SECONDS_PER_DAY, 0 );
+}
+
+PyObject * fudgepyc_convertTimeToPythonEpoch ( FudgeTime * source )
+{
+    return fudgepyc_convertSecondsToPythonNanos ( source->seconds,
+                                                  source->nanoseconds );
+}
+
+PyObject * fudgepyc_convertDateTimeToPythonEpoch ( FudgeDateTime * source )
+{
+    PY_LONG_LONG seconds = fudgepyc_getEpochDays ( &source->date ) * CONVERTER_SECONDS_PER_DAY +
+                           source->time.seconds;
+
+    /* The Fudge fields hold the local time, the epoch is in UTC */
+    if ( source->time.hasTimezone )
+        seconds -= source->time.timezoneOffset * 900;
+    return fudgepyc_convertSecondsToPythonNanos ( seconds, source->time.nanoseconds );
+}
+
 #define CONVERT_ARRAY_TO_PYTHON_SEQ( TYPENAME, CTYPE )                      \
 PyObject * fudgepyc_convert ## TYPENAME ## ArrayToPython (                  \
                const fudge_byte * bytes,                                    \
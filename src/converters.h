@@ -58,6 +58,14 @@ extern int fudgepyc_convertPythonToDateTimeEx ( FudgeDateTime * target,
                                                 PyObject * nanoobj,
                                                 PyObject * offsetobj );
 
+/* Sets target to the date and time nanos nanoseconds after the Unix epoch
+ * (UTC). If offsetobj is not null it is the timezone, in fifteen minute
+ * intervals, that the date and time are given in. */
+extern int fudgepyc_convertPythonToDateTimeFromEpoch ( FudgeDateTime * target,
+                                                       unsigned int precision,
+                                                       PyObject * nanosobj,
+                                                       PyObject * offsetobj );
+
 extern int fudgepyc_convertPythonToByteArray ( fudge_byte * * target,
                                                fudge_i32 * size,
                                                PyObject * source );
@@ -77,6 +85,40 @@ extern int fudgepyc_convertPythonToF64Array ( fudge_f64 * * target,
                                               fudge_i32 * targetsize,
                                               PyObject * source );
 
+/* A contiguous block of numbers exposed by a buffer interface object:
+ * kind is 'i' for signed integers, 'u' for unsigned and 'f' for floating
+ * point. The view is only held if hasview is set. */
+typedef struct
+{
+    Py_buffer view;
+    int hasview;
+    const void * data;
+    Py_ssize_t count;
+    char kind;
+    Py_ssize_t itemsize;
+} ConverterBuffer;
+
+/* A numeric array converted from Python. If the source's buffer already
+ * holds elements of the target type then data points straight in to it,
+ * otherwise data is a converted copy. Either way it is only valid until
+ * fudgepyc_releaseArray is called, so should be passed directly to a
+ * FudgeMsg_addField*Array function (which takes its own copy). */
+typedef struct
+{
+    const void * data;
+    fudge_i32 size;
+    void * copy;
+    ConverterBuffer buffer;
+} ConverterArray;
+
+extern int fudgepyc_getPythonByteArray ( ConverterArray * array, PyObject * source );
+extern int fudgepyc_getPythonI16Array ( ConverterArray * array, PyObject * source );
+extern int fudgepyc_getPythonI32Array ( ConverterArray * array, PyObject * source );
+extern int fudgepyc_getPythonI64Array ( ConverterArray * array, PyObject * source );
+extern int fudgepyc_getPythonF32Array ( ConverterArray * array, PyObject * source );
+extern int fudgepyc_getPythonF64Array ( ConverterArray * array, PyObject * source );
+extern void fudgepyc_releaseArray ( ConverterArray * array );
+
 extern int fudgepyc_convertPythonToFixedByteArray ( fudge_byte * target,
                                                     fudge_i32 size,
                                                     PyObject * source );
@@ -90,6 +132,7 @@ extern PyObject * fudgepyc_convertF32ToPython ( fudge_f32 source );
 extern PyObject * fudgepyc_convertF64ToPython ( fudge_f64 source );
 
 extern PyObject * fudgepyc_convertStringToPython ( FudgeString source );
+extern PyObject * fudgepyc_convertStringToPythonAscii ( FudgeString source );
 
 extern PyObject * fudgepyc_convertDateToPython ( FudgeDate * source );
 extern PyObject * fudgepyc_convertTimeToPython ( FudgeTime * source );
@@ -99,6 +142,14 @@ extern PyObject * fudgepyc_convertDateToPythonEx ( FudgeDate * source );
 extern PyObject * fudgepyc_convertTimeToPythonEx ( FudgeTime * source );
 extern PyObject * fudgepyc_convertDateTimeToPythonEx ( FudgeDateTime * source );
 
+/* Date/time values as a Python long of nanoseconds: Dates from the Unix
+ * epoch to midnight UTC, Times from midnight (in the time's own timezone)
+ * and DateTimes from the Unix epoch, adjusted to UTC if they have a
+ * timezone */
+extern PyObject * fudgepyc_convertDateToPythonEpoch ( FudgeDate * source );
+extern PyObject * fudgepyc_convertTimeToPythonEpoch ( FudgeTime * source );
+extern PyObject * fudgepyc_convertDateTimeToPythonEpoch ( FudgeDateTime * source );
+
 extern PyObject * fudgepyc_convertByteArrayToPython ( const fudge_byte * bytes,
                                                       fudge_i32 numbytes );
 extern PyObject * fudgepyc_convertI16ArrayToPython ( const fudge_byte * bytes,
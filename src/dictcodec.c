@@ -0,0 +1,576 @@
+/**
+ * Copyright (C) 2012 - 2012, Vrai Stacey.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "dictcodec.h"
+#include "converters.h"
+#include "field.h"
+#include "message.h"
+#include <fudge/codec.h>
+#include <fudge/envelope.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef enum
+{
+    DICTCODEC_REPEATED_LIST = 0,
+    DICTCODEC_REPEATED_FIRST,
+    DICTCODEC_REPEATED_LAST,
+    DICTCODEC_REPEATED_ERROR
+} DictCodecRepeated;
+
+typedef enum
+{
+    DICTCODEC_ORDINALS_INT = 0,
+    DICTCODEC_ORDINALS_STR,
+    DICTCODEC_ORDINALS_IGNORE
+} DictCodecOrdinals;
+
+/* Policy names, in the same order as the enumerations above */
+static const char * const DictCodec_repeatedNames [] = { "list", "first", "last", "error", 0 };
+static const char * const DictCodec_ordinalsNames [] = { "int", "str", "ignore", 0 };
+
+typedef struct
+{
+    DictCodecRepeated repeated;
+    DictCodecOrdinals ordinals;
+    FieldValueOptions values;
+} DictCodecOptions;
+
+static int DictCodec_parsePolicy ( int * target,
+                                   const char * value,
+                                   const char * const * names,
+                                   const char * param )
+{
+    int index;
+
+    for ( index = 0; names [ index ]; ++index )
+    {
+        if ( ! strcmp ( value, names [ index ] ) )
+        {
+            *target = index;
+            return 0;
+        }
+    }
+
+    exception_raise_any ( PyExc_ValueError,
+                          "Unknown %s policy \"%s\"",
+                          param,
+                          value );
+    return -1;
+}
+
+
+/****************************************************************************
+ * Loading (decoded FudgeMsg to Python containers)
+ */
+
+static PyObject * DictCodec_loadMessage ( FudgeMsg message,
+                                          const DictCodecOptions * options );
+
+/* Sub-messages are loaded as containers, rather than wrapped as Messages */
+static PyObject * DictCodec_loadSubMessage ( FudgeMsg message, void * options )
+{
+    return DictCodec_loadMessage ( message, ( const DictCodecOptions * ) options );
+}
+
+/* Sets key to a new reference to the dict key for the field. Returns 0 on
+ * success (key will be null if the field should be skipped) or -1 with a
+ * Python exception set. */
+static int DictCodec_loadKey ( PyObject * * key,
+                               const FudgeField * field,
+                               const DictCodecOptions * options )
+{
+    if ( field->flags & FUDGE_FIELD_HAS_NAME )
+        *key = options->values.asciistr ? fudgepyc_convertStringToPythonAscii ( field->name )
+                                 : fudgepyc_convertStringToPython ( field->name );
+    else if ( field->flags & FUDGE_FIELD_HAS_ORDINAL )
+    {
+        switch ( options->ordinals )
+        {
+            case DICTCODEC_ORDINALS_INT:
+                *key = PyInt_FromLong ( field->ordinal );
+                break;
+            case DICTCODEC_ORDINALS_STR:
+                *key = PyString_FromFormat ( "%d", ( int ) field->ordinal );
+                break;
+            default:
+                *key = 0;
+                return 0;
+        }
+    }
+    else
+    {
+        Py_INCREF( Py_None );
+        *key = Py_None;
+    }
+    return *key ? 0 : -1;
+}
+
+/* Adds the key/value pair to dict, applying the repeated key policy.
+ * Under the "list" policy, promoted holds the keys whose values have
+ * already been collected in to a list; it is created when first needed. */
+static int DictCodec_storeValue ( PyObject * dict,
+                                  PyObject * * promoted,
+                                  PyObject * key,
+                                  PyObject * value,
+                                  const DictCodecOptions * options )
+{
+    PyObject * existing, * list, * repr;
+    int result;
+
+    if ( ! ( existing = PyDict_GetItem ( dict, key ) ) )
+        return PyDict_SetItem ( dict, key, value );
+
+    switch ( options->repeated )
+    {
+        case DICTCODEC_REPEATED_FIRST:
+            return 0;
+
+        case DICTCODEC_REPEATED_LAST:
+            return PyDict_SetItem ( dict, key, value );
+
+        case DICTCODEC_REPEATED_ERROR:
+            repr = PyObject_Repr ( key );
+            exception_raise_any ( PyExc_ValueError,
+                                  "Cannot load message, field key %s is repeated",
+                                  repr ? PyString_AS_STRING( repr ) : "?" );
+            Py_XDECREF( repr );
+            return -1;
+
+        default:
+            break;
+    }
+
+    if ( *promoted )
+    {
+        if ( ( result = PySet_Contains ( *promoted, key ) ) < 0 )
+            return -1;
+        if ( result )
+            return PyList_Append ( existing, value );
+    }
+    else if ( ! ( *promoted = PySet_New ( 0 ) ) )
+        return -1;
+
+    /* Second occurrence of the key: replace the value with a list */
+    if ( ! ( list = PyList_New ( 2 ) ) )
+        return -1;
+    Py_INCREF( existing );
+    Py_INCREF( value );
+    PyList_SET_ITEM( list, 0, existing );
+    PyList_SET_ITEM( list, 1, value );
+
+    result = PyDict_SetItem ( dict, key, list );
+    Py_DECREF( list );
+    if ( result )
+        return -1;
+    return PySet_Add ( *promoted, key );
+}
+
+static PyObject * DictCodec_loadMessage ( FudgeMsg message,
+                                          const DictCodecOptions * options )
+{
+    PyObject * dict, * promoted = 0, * key, * value;
+    FudgeField * fields = 0;
+    fudge_i32 numfields, index;
+    int result;
+
+    if ( Py_EnterRecursiveCall ( " while loading a Fudge message" ) )
+        return 0;
+
+    if ( ! ( dict = PyDict_New ( ) ) )
+        goto leave_and_return;
+    if ( ! ( numfields = ( fudge_i32 ) FudgeMsg_numFields ( message ) ) )
+        goto leave_and_return;
+
+    if ( ! ( fields = PyMem_New ( FudgeField, numfields ) ) )
+    {
+        PyErr_NoMemory ( );
+        goto clear_dict_and_fail;
+    }
+    numfields = FudgeMsg_getFields ( fields, numfields, message );
+
+    for ( index = 0; index < numfields; ++index )
+    {
+        if ( DictCodec_loadKey ( &key, fields + index, options ) )
+            goto clear_dict_and_fail;
+        if ( ! key )
+            continue;
+
+        if ( ! ( value = Field_convertValue ( fields + index,
+                                              &options->values,
+                                              DictCodec_loadSubMessage,
+                                              ( void * ) options ) ) )
+        {
+            Py_DECREF( key );
+            goto clear_dict_and_fail;
+        }
+
+        result = DictCodec_storeValue ( dict, &promoted, key, value, options );
+        Py_DECREF( key );
+        Py_DECREF( value );
+        if ( result )
+            goto clear_dict_and_fail;
+    }
+    goto leave_and_return;
+
+clear_dict_and_fail:
+    Py_CLEAR( dict );
+leave_and_return:
+    PyMem_Free ( fields );
+    Py_XDECREF( promoted );
+    Py_LeaveRecursiveCall ( );
+    return dict;
+}
+
+PyObject * fudgepyc_loads ( PyObject * self, PyObject * args, PyObject * kwds )
+{
+    static char * kwlist [] = { "buffer", "repeated", "ordinals", "epochnanos", "asciistr", 0 };
+
+    const char * repeated = "list", * ordinals = "int";
+    DictCodecOptions options;
+    FudgeMsgEnvelope envelope;
+    FudgeStatus status;
+    PyObject * buffer, * target;
+    const void * bytes;
+    Py_ssize_t numbytes;
+    int policy;
+
+    options.values.epochnanos = 0;
+    options.values.asciistr = 0;
+    if ( ! PyArg_ParseTupleAndKeywords ( args, kwds, "O|ssii", kwlist,
+                                         &buffer, &repeated, &ordinals,
+                                         &options.values.epochnanos,
+                                         &options.values.asciistr ) )
+        return 0;
+
+    if ( DictCodec_parsePolicy ( &policy, repeated, DictCodec_repeatedNames, "repeated" ) )
+        return 0;
+    options.repeated = ( DictCodecRepeated ) policy;
+    if ( DictCodec_parsePolicy ( &policy, ordinals, DictCodec_ordinalsNames, "ordinals" ) )
+        return 0;
+    options.ordinals = ( DictCodecOrdinals ) policy;
+
+    if ( ! PyObject_CheckReadBuffer ( buffer ) )
+    {
+        exception_raise_any ( PyExc_TypeError,
+                              "Cannot decode object that doesn't implement "
+                              "the Buffer protocol (e.g. String)" );
+        return 0;
+    }
+    if ( PyObject_AsReadBuffer ( buffer, &bytes, &numbytes ) )
+        return 0;
+
+    Py_BEGIN_ALLOW_THREADS
+    status = FudgeCodec_decodeMsg ( &envelope, bytes, ( fudge_i32 ) numbytes );
+    Py_END_ALLOW_THREADS
+
+    if ( exception_raiseOnError ( status ) )
+        return 0;
+
+    target = DictCodec_loadMessage ( FudgeMsgEnvelope_getMessage ( envelope ),
+                                     &options );
+    FudgeMsgEnvelope_release ( envelope );
+    return target;
+}
+
+
+/****************************************************************************
+ * Dumping (Python containers to FudgeMsg)
+ */
+
+static int DictCodec_dumpDict ( FudgeMsg message, PyObject * dict );
+
+/* Converts a dict key in to a field name and/or ordinal: Strings become
+ * names, ints become ordinals and None gives an anonymous field. The
+ * caller must release name. */
+static int DictCodec_dumpKey ( FudgeString * name,
+                               fudge_i16 * ordinal,
+                               int * hasordinal,
+                               PyObject * key )
+{
+    *name = 0;
+    *hasordinal = 0;
+
+    if ( key == Py_None )
+        return 0;
+    if ( PyString_Check ( key ) || PyUnicode_Check ( key ) )
+        return Message_parseNameObject ( name, key );
+    if ( PyInt_Check ( key ) && ! PyBool_Check ( key ) )
+    {
+        *hasordinal = 1;
+        return Message_parseOrdinalObject ( ordinal, key );
+    }
+
+    exception_raise_any ( PyExc_TypeError,
+                          "Cannot dump dict key, only String, Unicode, int "
+                          "and None keys are supported" );
+    return -1;
+}
+
+static int DictCodec_dumpSubMessage ( FudgeMsg message,
+                                      FudgeString name,
+                                      const fudge_i16 * ordinal,
+                                      PyObject * dict )
+{
+    FudgeMsg submsg;
+    int result;
+
+    if ( exception_raiseOnError ( FudgeMsg_create ( &submsg ) ) )
+        return -1;
+
+    if ( ! ( result = DictCodec_dumpDict ( submsg, dict ) ) )
+        result = exception_raiseOnError (
+                     FudgeMsg_addFieldMsg ( message, name, ordinal, submsg ) );
+    FudgeMsg_release ( submsg );
+    return result;
+}
+
+static int DictCodec_dumpScalar ( FudgeMsg message,
+                                  FudgeString name,
+                                  const fudge_i16 * ordinal,
+                                  PyObject * value )
+{
+    FudgeStatus status;
+    fudge_type_id type;
+    fudge_bool boolean;
+    fudge_i64 i64;
+    fudge_f64 f64;
+    FudgeString string;
+    FudgeDateTime datetime;
+
+    if ( Message_getFudgeType ( &type, value ) )
+    {
+        exception_raise_any ( PyExc_TypeError,
+                              "Cannot determine Fudge type for %s",
+                              value->ob_type->tp_name );
+        return -1;
+    }
+
+    memset ( &datetime, 0, sizeof ( datetime ) );
+
+    switch ( type )
+    {
+        case FUDGE_TYPE_INDICATOR:
+            status = FudgeMsg_addFieldIndicator ( message, name, ordinal );
+            break;
+
+        case FUDGE_TYPE_BOOLEAN:
+            if ( fudgepyc_convertPythonToBool ( &boolean, value ) )
+                return -1;
+            status = FudgeMsg_addFieldBool ( message, name, ordinal, boolean );
+            break;
+
+        case FUDGE_TYPE_LONG:
+            if ( fudgepyc_convertPythonToI64 ( &i64, value ) )
+                return -1;
+            status = FudgeMsg_addFieldI64 ( message, name, ordinal, i64 );
+            break;
+
+        case FUDGE_TYPE_DOUBLE:
+            if ( fudgepyc_convertPythonToF64 ( &f64, value ) )
+                return -1;
+            status = FudgeMsg_addFieldF64 ( message, name, ordinal, f64 );
+            break;
+
+        case FUDGE_TYPE_STRING:
+            if ( fudgepyc_convertPythonToString ( &string, value ) )
+                return -1;
+            status = FudgeMsg_addFieldString ( message, name, ordinal, string );
+            FudgeString_release ( string );
+            break;
+
+        case FUDGE_TYPE_FUDGE_MSG:
+            status = FudgeMsg_addFieldMsg ( message,
+                                            name,
+                                            ordinal,
+                                            ( ( Message * ) value )->msg );
+            break;
+
+        case FUDGE_TYPE_DATE:
+            if ( fudgepyc_convertPythonToDate ( &datetime.date, value ) )
+                return -1;
+            status = FudgeMsg_addFieldDate ( message, name, ordinal, &datetime.date );
+            break;
+
+        case FUDGE_TYPE_TIME:
+            if ( fudgepyc_convertPythonToTime ( &datetime.time, value ) )
+                return -1;
+            status = FudgeMsg_addFieldTime ( message, name, ordinal, &datetime.time );
+            break;
+
+        default:
+            if ( fudgepyc_convertPythonToDateTime ( &datetime, value ) )
+                return -1;
+            status = FudgeMsg_addFieldDateTime ( message, name, ordinal, &datetime );
+            break;
+    }
+
+    return exception_raiseOnError ( status );
+}
+
+static int DictCodec_dumpValue ( FudgeMsg message,
+                                 FudgeString name,
+                                 const fudge_i16 * ordinal,
+                                 PyObject * value );
+
+/* Lists and tuples containing only ints (or nothing at all) become Long[]
+ * fields, those containing floats, or a mix of floats and ints, become
+ * Double[] fields. Anything else is added as a repeated field, one per
+ * element. */
+static int DictCodec_dumpSequence ( FudgeMsg message,
+                                    FudgeString name,
+                                    const fudge_i16 * ordinal,
+                                    PyObject * sequence )
+{
+    PyObject * * items = PySequence_Fast_ITEMS( sequence );
+    Py_ssize_t size = PySequence_Fast_GET_SIZE( sequence ), index;
+    int allints = 1, allnumbers = 1, isint, result = 0;
+    FudgeStatus status;
+    fudge_i64 * i64s;
+    fudge_f64 * f64s;
+    fudge_i32 count;
+
+    for ( index = 0; index < size && allnumbers; ++index )
+    {
+        isint = ( PyInt_Check ( items [ index ] ) || PyLong_Check ( items [ index ] ) ) &&
+                ! PyBool_Check ( items [ index ] );
+        if ( ! isint )
+            allints = 0;
+        if ( ! ( isint || PyFloat_Check ( items [ index ] ) ) )
+            allnumbers = 0;
+    }
+
+    if ( allints )
+    {
+        if ( fudgepyc_convertPythonToI64Array ( &i64s, &count, sequence ) )
+            return -1;
+        status = FudgeMsg_addFieldI64Array ( message, name, ordinal, i64s, count );
+        PyMem_Free ( i64s );
+        return exception_raiseOnError ( status );
+    }
+
+    if ( allnumbers )
+    {
+        if ( fudgepyc_convertPythonToF64Array ( &f64s, &count, sequence ) )
+            return -1;
+        status = FudgeMsg_addFieldF64Array ( message, name, ordinal, f64s, count );
+        PyMem_Free ( f64s );
+        return exception_raiseOnError ( status );
+    }
+
+    for ( index = 0; index < size && ! result; ++index )
+        result = DictCodec_dumpValue ( message, name, ordinal, items [ index ] );
+    return result;
+}
+
+static int DictCodec_dumpValue ( FudgeMsg message,
+                                 FudgeString name,
+                                 const fudge_i16 * ordinal,
+                                 PyObject * value )
+{
+    PyObject * sequence;
+    int result;
+
+    if ( PyDict_Check ( value ) )
+        return DictCodec_dumpSubMessage ( message, name, ordinal, value );
+
+    if ( PyList_Check ( value ) || PyTuple_Check ( value ) )
+    {
+        if ( ! ( sequence = PySequence_Fast ( value, "" ) ) )
+            return -1;
+        result = DictCodec_dumpSequence ( message, name, ordinal, sequence );
+        Py_DECREF( sequence );
+        return result;
+    }
+
+    return DictCodec_dumpScalar ( message, name, ordinal, value );
+}
+
+static int DictCodec_dumpDict ( FudgeMsg message, PyObject * dict )
+{
+    PyObject * key, * value;
+    Py_ssize_t position = 0;
+    FudgeString name;
+    fudge_i16 ordinal;
+    int hasordinal, result = 0;
+
+    if ( Py_EnterRecursiveCall ( " while dumping a Fudge message" ) )
+        return -1;
+
+    while ( ! result && PyDict_Next ( dict, &position, &key, &value ) )
+    {
+        /* Hold on to the pair, in case a conversion modifies the dict */
+        Py_INCREF( key );
+        Py_INCREF( value );
+
+        if ( ! ( result = DictCodec_dumpKey ( &name, &ordinal, &hasordinal, key ) ) )
+        {
+            result = DictCodec_dumpValue ( message,
+                                           name,
+                                           hasordinal ? &ordinal : 0,
+                                           value );
+            FudgeString_release ( name );
+        }
+
+        Py_DECREF( key );
+        Py_DECREF( value );
+    }
+
+    Py_LeaveRecursiveCall ( );
+    return result;
+}
+
+PyObject * fudgepyc_dumps ( PyObject * self, PyObject * args, PyObject * kwds )
+{
+    static char * kwlist [] = { "obj", "schema", "taxonomy", 0 };
+
+    PyObject * obj, * target = 0;
+    FudgeMsgEnvelope envelope;
+    FudgeMsg message;
+    FudgeStatus status;
+    fudge_byte * bytes;
+    fudge_i32 numbytes;
+    fudge_byte schema = 0;
+    fudge_i16 taxonomy = 0;
+
+    if ( ! PyArg_ParseTupleAndKeywords ( args, kwds, "O!|bh", kwlist,
+                                         &PyDict_Type, &obj,
+                                         &schema, &taxonomy ) )
+        return 0;
+
+    if ( exception_raiseOnError ( FudgeMsg_create ( &message ) ) )
+        return 0;
+    if ( DictCodec_dumpDict ( message, obj ) )
+        goto release_message_and_return;
+
+    status = FudgeMsgEnvelope_create ( &envelope, 0, schema, taxonomy, message );
+    if ( exception_raiseOnError ( status ) )
+        goto release_message_and_return;
+
+    Py_BEGIN_ALLOW_THREADS
+    status = FudgeCodec_encodeMsg ( envelope, &bytes, &numbytes );
+    Py_END_ALLOW_THREADS
+
+    FudgeMsgEnvelope_release ( envelope );
+    if ( exception_raiseOnError ( status ) )
+        goto release_message_and_return;
+
+    target = PyString_FromStringAndSize ( ( const char * ) bytes, numbytes );
+    free ( bytes );
+
+release_message_and_return:
+    FudgeMsg_release ( message );
+    return target;
+}
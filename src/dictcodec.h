@@ -0,0 +1,80 @@
+/**
+ * Copyright (C) 2012 - 2012, Vrai Stacey.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef INC_FUDGEPYC_DICTCODEC_H
+#define INC_FUDGEPYC_DICTCODEC_H
+
+#include "exception.h"
+
+/* Conversion between encoded Fudge envelopes and plain Python containers,
+ * bypassing the Envelope, Message and Field wrappers */
+
+static const char DOC_fudgepyc_loads [] =
+    "\nDecode an encoded envelope directly in to a dict, without creating\n"
+    "any Envelope, Message or Field objects. Each field becomes a key/value\n"
+    "pair: sub-messages become nested dicts and all other values are\n"
+    "converted as by Field.value, except that byte arrays are always Strings.\n"
+    "The envelope header is discarded.\n\n"
+    "A field is keyed by its name, or by its ordinal if it has no name;\n"
+    "fields with neither are keyed by None. The repeated policy controls\n"
+    "what happens when more than one field in a message has the same key:\n\n"
+    "  - \"list\": the values are collected in a list, in message order\n"
+    "  - \"first\": the first value is kept\n"
+    "  - \"last\": the last value is kept\n"
+    "  - \"error\": ValueError is raised\n\n"
+    "Note that with the \"list\" policy a key only becomes a list if it has\n"
+    "more than one field, so a list of one non-numeric value passed to\n"
+    "fudgepyc.dumps comes back as the value itself.\n\n"
+    "The ordinals policy controls how ordinal-only fields are keyed:\n\n"
+    "  - \"int\": by the ordinal as an int\n"
+    "  - \"str\": by the ordinal as a String (e.g. for JSON output)\n"
+    "  - \"ignore\": the fields are skipped\n\n"
+    "If asciistr is True, String values (and field name keys) that only\n"
+    "contain ASCII characters are str rather than Unicode.\n\n"
+    "If epochnanos is True, Date, Time and DateTime values are integer\n"
+    "nanoseconds, as by Field.getEpochNanos.\n\n"
+    "Note that this method will release the GIL during decoding.\n\n"
+    "@param buffer: buffer object (e.g. String) containing the encoded envelope\n"
+    "@param repeated: policy for repeated keys, defaults to \"list\"\n"
+    "@param ordinals: policy for ordinal-only fields, defaults to \"int\"\n"
+    "@param epochnanos: if True, return date/time values as nanoseconds,\n"
+    "                   defaults to False\n"
+    "@param asciistr: if True, return ASCII-only strings as str, defaults to\n"
+    "                 False\n"
+    "@return: dict of the message's fields\n";
+extern PyObject * fudgepyc_loads ( PyObject * self, PyObject * args, PyObject * kwds );
+
+static const char DOC_fudgepyc_dumps [] =
+    "\nEncode a dict directly as a Fudge envelope, without creating any\n"
+    "Envelope, Message or Field objects. Each key/value pair becomes a field.\n"
+    "String and Unicode keys become field names, int keys become ordinals\n"
+    "and a None key gives a field with neither. Values are mapped to Fudge\n"
+    "types as by Message.addField, with the following additions:\n\n"
+    "  - dict: a sub-message\n"
+    "  - list/tuple of int (or an empty list/tuple): Long[]\n"
+    "  - list/tuple of float, or of floats and ints: Double[]\n"
+    "  - any other list/tuple: one field per element, all with the same key\n\n"
+    "This is the inverse of fudgepyc.loads with the \"list\" repeated policy,\n"
+    "except that integer array fields of narrower types come back as Long[],\n"
+    "ints in a Double[] come back as floats, and a list/tuple holding a\n"
+    "single non-numeric value comes back as just that value.\n\n"
+    "Note that this method will release the GIL during encoding.\n\n"
+    "@param obj: dict to encode\n"
+    "@param schema: envelope schema version, defaults to 0\n"
+    "@param taxonomy: envelope taxonomy, defaults to 0\n"
+    "@return: String containing the encoded envelope\n";
+extern PyObject * fudgepyc_dumps ( PyObject * self, PyObject * args, PyObject * kwds );
+
+#endif
@@ -14,7 +14,9 @@
  * limitations under the License.
  */
 #include "envelope.h"
+#include "wire.h"
 #include <fudge/codec.h>
+#include <stdlib.h>
 
 /****************************************************************************
  * Constructor/destructor implementations
@@ -152,23 +154,715 @@ PyObject * Envelope_encode ( Envelope * self )
     return target;
 }
 
+static const char DOC_fudgepyc_envelope_encodedSize [] =
+    "\nGet the number of bytes the envelope will occupy when encoded, without\n"
+    "encoding it. Can be used to size the buffer passed to encodeInto.\n\n"
+    "@return: number of bytes\n";
+PyObject * Envelope_encodedSize ( Envelope * self )
+{
+    size_t size;
+    if ( Message_calculateEncodedSize ( FudgeMsgEnvelope_getMessage ( self->envelope ),
+                                        &size ) )
+        return 0;
+    return PyInt_FromSize_t ( WIRE_HEADER_SIZE + size );
+}
+
+static const char DOC_fudgepyc_envelope_encodeInto [] =
+    "\nEncodes the envelope contents and metadata directly in to a writable\n"
+    "buffer object (e.g. bytearray or mmap), starting at the given offset.\n"
+    "Avoids the String allocation made by Envelope.encode.\n\n"
+    "Note that this method will release the GIL during encoding.\n\n"
+    "@param buffer: writable buffer object to encode the Envelope in to\n"
+    "@param offset: byte offset within the buffer to start at, defaults to 0\n"
+    "@return: number of bytes written, or ValueError if the buffer is too\n"
+    "         small to hold the encoded Envelope\n";
+PyObject * Envelope_encodeInto ( Envelope * self, PyObject * args, PyObject * kwds )
+{
+    static char * kwlist [] = { "buffer", "offset", 0 };
+
+    PyObject * buffer;
+    Py_ssize_t offset = 0, available;
+    void * target;
+    fudge_byte * bytes;
+    fudge_i32 numbytes;
+    FudgeStatus status;
+
+    if ( ! PyArg_ParseTupleAndKeywords ( args, kwds, "O|n", kwlist,
+                                         &buffer, &offset ) )
+        return 0;
+
+    Py_BEGIN_ALLOW_THREADS
+    status = FudgeCodec_encodeMsg ( self->envelope, &bytes, &numbytes );
+    Py_END_ALLOW_THREADS
+
+    if ( exception_raiseOnError ( status ) )
+        return 0;
+
+    /* Only retrieve the target pointer once the GIL is held again, as the
+       buffer object may have been resized while encoding */
+    if ( PyObject_AsWriteBuffer ( buffer, &target, &available ) )
+        goto free_bytes_and_fail;
+
+    if ( offset < 0 || offset > available )
+    {
+        exception_raise_any ( PyExc_IndexError,
+                              "Offset %zd is outside of the %zd byte buffer",
+                              offset, available );
+        goto free_bytes_and_fail;
+    }
+
+    if ( available - offset < numbytes )
+    {
+        exception_raise_any ( PyExc_ValueError,
+                              "Buffer too small for encoded envelope; %d bytes "
+                              "required but only %zd available at offset %zd",
+                              numbytes, available - offset, offset );
+        goto free_bytes_and_fail;
+    }
+
+    memcpy ( ( char * ) target + offset, bytes, numbytes );
+    free ( bytes );
+    return PyInt_FromLong ( numbytes );
+
+free_bytes_and_fail:
+    free ( bytes );
+    return 0;
+}
+
+/* An envelope from a batch, together with its encoded bytes */
+typedef struct
+{
+    FudgeMsgEnvelope envelope;
+    fudge_byte * bytes;
+    fudge_i32 numbytes;
+} EnvelopeBatchItem;
+
+static void Envelope_releaseBatch ( EnvelopeBatchItem * items, Py_ssize_t count )
+{
+    Py_ssize_t index;
+    for ( index = 0; index < count; ++index )
+    {
+        free ( items [ index ].bytes );
+        FudgeMsgEnvelope_release ( items [ index ].envelope );
+    }
+    PyMem_Free ( items );
+}
+
+/* Encodes every Envelope in the sequence, releasing the GIL once for the
+ * whole batch. The C envelopes are retained so that the batch is unaffected
+ * if the sequence is modified while the GIL is released. */
+static EnvelopeBatchItem * Envelope_encodeBatch ( PyObject * envelopes,
+                                                  Py_ssize_t * count,
+                                                  size_t * total )
+{
+    PyObject * sequence, * item;
+    EnvelopeBatchItem * items;
+    FudgeStatus status = FUDGE_OK;
+    Py_ssize_t index;
+
+    if ( ! ( sequence = PySequence_Fast ( envelopes,
+                                          "Envelopes must be a sequence" ) ) )
+        return 0;
+
+    *count = PySequence_Fast_GET_SIZE( sequence );
+    for ( index = 0; index < *count; ++index )
+    {
+        item = PySequence_Fast_GET_ITEM( sequence, index );
+        if ( ! PyObject_TypeCheck ( item, &EnvelopeType ) )
+        {
+            exception_raise_any ( PyExc_TypeError,
+                                  "Item %zd in batch is not an Envelope",
+                                  index );
+            Py_DECREF( sequence );
+            return 0;
+        }
+    }
+
+    if ( ! ( items = PyMem_New ( EnvelopeBatchItem, *count ? *count : 1 ) ) )
+    {
+        Py_DECREF( sequence );
+        PyErr_NoMemory ( );
+        return 0;
+    }
+    for ( index = 0; index < *count; ++index )
+    {
+        item = PySequence_Fast_GET_ITEM( sequence, index );
+        FudgeMsgEnvelope_retain ( ( items [ index ].envelope =
+                                        ( ( Envelope * ) item )->envelope ) );
+        items [ index ].bytes = 0;
+        items [ index ].numbytes = 0;
+    }
+    Py_DECREF( sequence );
+
+    *total = 0;
+    Py_BEGIN_ALLOW_THREADS
+    for ( index = 0; index < *count; ++index )
+    {
+        if ( ( status = FudgeCodec_encodeMsg ( items [ index ].envelope,
+                                               &items [ index ].bytes,
+                                               &items [ index ].numbytes ) ) != FUDGE_OK )
+            break;
+        *total += items [ index ].numbytes;
+    }
+    Py_END_ALLOW_THREADS
+
+    if ( exception_raiseOnError ( status ) )
+    {
+        Envelope_releaseBatch ( items, *count );
+        return 0;
+    }
+    return items;
+}
+
+/* Copies the encoded batch, back-to-back, in to the target */
+static void Envelope_copyBatch ( fudge_byte * target,
+                                 const EnvelopeBatchItem * items,
+                                 Py_ssize_t count )
+{
+    Py_ssize_t index;
+    for ( index = 0; index < count; ++index )
+    {
+        memcpy ( target, items [ index ].bytes, items [ index ].numbytes );
+        target += items [ index ].numbytes;
+    }
+}
+
+static const char DOC_fudgepyc_envelope_encodeMany [] =
+    "\nEncodes a batch of envelopes, back-to-back, in to a single String of\n"
+    "bytes. Equivalent to joining the output of Envelope.encode for each\n"
+    "envelope, without the temporary Strings.\n\n"
+    "Note that this method will release the GIL once, while encoding the\n"
+    "entire batch.\n\n"
+    "@param envelopes: sequence of Envelope instances\n"
+    "@return: String instance containing the encoded Envelopes\n";
+PyObject * Envelope_encodeMany ( PyTypeObject * type, PyObject * args, PyObject * kwds )
+{
+    static char * kwlist [] = { "envelopes", 0 };
+
+    PyObject * envelopes, * target;
+    EnvelopeBatchItem * items;
+    Py_ssize_t count;
+    size_t total;
+
+    if ( ! PyArg_ParseTupleAndKeywords ( args, kwds, "O", kwlist, &envelopes ) )
+        return 0;
+
+    if ( ! ( items = Envelope_encodeBatch ( envelopes, &count, &total ) ) )
+        return 0;
+
+    if ( ( target = PyString_FromStringAndSize ( 0, total ) ) )
+        Envelope_copyBatch ( ( fudge_byte * ) PyString_AS_STRING( target ),
+                             items,
+                             count );
+    Envelope_releaseBatch ( items, count );
+    return target;
+}
+
+static const char DOC_fudgepyc_envelope_encodeManyInto [] =
+    "\nEncodes a batch of envelopes, back-to-back, directly in to a writable\n"
+    "buffer object (e.g. bytearray or mmap), starting at the given offset.\n"
+    "Nothing is written if the buffer is too small for the entire batch.\n\n"
+    "Note that this method will release the GIL once, while encoding the\n"
+    "entire batch.\n\n"
+    "@param envelopes: sequence of Envelope instances\n"
+    "@param buffer: writable buffer object to encode the Envelopes in to\n"
+    "@param offset: byte offset within the buffer to start at, defaults to 0\n"
+    "@return: number of bytes written, or ValueError if the buffer is too\n"
+    "         small to hold the encoded Envelopes\n";
+PyObject * Envelope_encodeManyInto ( PyTypeObject * type, PyObject * args, PyObject * kwds )
+{
+    static char * kwlist [] = { "envelopes", "buffer", "offset", 0 };
+
+    PyObject * envelopes, * buffer, * result = 0;
+    Py_ssize_t offset = 0, available, count;
+    EnvelopeBatchItem * items;
+    void * target;
+    size_t total;
+
+    if ( ! PyArg_ParseTupleAndKeywords ( args, kwds, "OO|n", kwlist,
+                                         &envelopes, &buffer, &offset ) )
+        return 0;
+
+    if ( ! ( items = Envelope_encodeBatch ( envelopes, &count, &total ) ) )
+        return 0;
+
+    /* As with encodeInto, only retrieve the target pointer once the GIL is
+       held again */
+    if ( PyObject_AsWriteBuffer ( buffer, &target, &available ) )
+        goto release_batch_and_return;
+
+    if ( offset < 0 || offset > available )
+    {
+        exception_raise_any ( PyExc_IndexError,
+                              "Offset %zd is outside of the %zd byte buffer",
+                              offset, available );
+        goto release_batch_and_return;
+    }
+
+    if ( ( size_t ) ( available - offset ) < total )
+    {
+        exception_raise_any ( PyExc_ValueError,
+                              "Buffer too small for encoded envelopes; %zu "
+                              "bytes required but only %zd available at "
+                              "offset %zd",
+                              total, available - offset, offset );
+        goto release_batch_and_return;
+    }
+
+    Envelope_copyBatch ( ( fudge_byte * ) target + offset, items, count );
+    result = PyInt_FromSize_t ( total );
+
+release_batch_and_return:
+    Envelope_releaseBatch ( items, count );
+    return result;
+}
+
+/* Growable byte buffer used to build a filtered copy of an envelope. It is
+ * filled with the GIL released, so uses the C allocator. */
+typedef struct
+{
+    fudge_byte * bytes;
+    size_t size;
+    size_t capacity;
+} EnvelopeOutput;
+
+static WireStatus EnvelopeOutput_append ( EnvelopeOutput * output,
+                                          const void * bytes,
+                                          size_t numbytes )
+{
+    fudge_byte * resized;
+    size_t capacity;
+
+    if ( output->capacity - output->size < numbytes )
+    {
+        capacity = output->capacity ? output->capacity : 256;
+        while ( capacity - output->size < numbytes )
+            capacity *= 2;
+        if ( ! ( resized = ( fudge_byte * ) realloc ( output->bytes, capacity ) ) )
+            return WIRE_NO_MEMORY;
+        output->bytes = resized;
+        output->capacity = capacity;
+    }
+
+    memcpy ( output->bytes + output->size, bytes, numbytes );
+    output->size += numbytes;
+    return WIRE_OK;
+}
+
+/* A field selection, compiled from the Python fields collection so that
+ * encoded fields can be matched without the GIL and without creating any
+ * Python objects. Each level holds the selected ordinals, sorted by value,
+ * and the selected names, UTF8 encoded and sorted by length then bytes. */
+typedef struct EnvelopeSelection EnvelopeSelection;
+
+typedef struct
+{
+    fudge_i16 ordinal;
+    char * name;                    /* Null for ordinal keys */
+    size_t namelen;
+    EnvelopeSelection * nested;     /* Null if the entire field is wanted */
+} EnvelopeSelectionKey;
+
+typedef struct
+{
+    EnvelopeSelectionKey * keys;
+    size_t count;
+    size_t capacity;
+} EnvelopeSelectionKeys;
+
+struct EnvelopeSelection
+{
+    EnvelopeSelectionKeys ordinals;
+    EnvelopeSelectionKeys names;
+};
+
+static void Envelope_clearSelection ( EnvelopeSelection * selection );
+
+static void Envelope_clearSelectionKeys ( EnvelopeSelectionKeys * keys )
+{
+    size_t index;
+
+    for ( index = 0; index < keys->count; ++index )
+    {
+        free ( keys->keys [ index ].name );
+        if ( keys->keys [ index ].nested )
+        {
+            Envelope_clearSelection ( keys->keys [ index ].nested );
+            free ( keys->keys [ index ].nested );
+        }
+    }
+    free ( keys->keys );
+}
+
+static void Envelope_clearSelection ( EnvelopeSelection * selection )
+{
+    Envelope_clearSelectionKeys ( &selection->ordinals );
+    Envelope_clearSelectionKeys ( &selection->names );
+}
+
+static int Envelope_compareOrdinalKeys ( const void * x, const void * y )
+{
+    return ( int ) ( ( const EnvelopeSelectionKey * ) x )->ordinal
+         - ( int ) ( ( const EnvelopeSelectionKey * ) y )->ordinal;
+}
+
+static int Envelope_compareNameKeys ( const void * x, const void * y )
+{
+    const EnvelopeSelectionKey * left = ( const EnvelopeSelectionKey * ) x,
+                               * right = ( const EnvelopeSelectionKey * ) y;
+
+    if ( left->namelen != right->namelen )
+        return left->namelen < right->namelen ? -1 : 1;
+    return memcmp ( left->name, right->name, left->namelen );
+}
+
+static void Envelope_sortSelection ( EnvelopeSelection * selection )
+{
+    EnvelopeSelectionKeys * levels [] = { &selection->ordinals, &selection->names };
+    size_t level, index;
+
+    qsort ( selection->ordinals.keys, selection->ordinals.count,
+            sizeof ( EnvelopeSelectionKey ), Envelope_compareOrdinalKeys );
+    qsort ( selection->names.keys, selection->names.count,
+            sizeof ( EnvelopeSelectionKey ), Envelope_compareNameKeys );
+
+    for ( level = 0; level < 2; ++level )
+        for ( index = 0; index < levels [ level ]->count; ++index )
+            if ( levels [ level ]->keys [ index ].nested )
+                Envelope_sortSelection ( levels [ level ]->keys [ index ].nested );
+}
+
+/* Returns the key in keys that matches probe, adding a copy of probe (and
+ * setting created) if there isn't one; the keys are only sorted once
+ * parsing is complete. Returns null, with an exception set, on failure. */
+static EnvelopeSelectionKey * Envelope_getSelectionKey (
+    EnvelopeSelectionKeys * keys,
+    const EnvelopeSelectionKey * probe,
+    int ( *compare ) ( const void *, const void * ),
+    int * created )
+{
+    EnvelopeSelectionKey * key, * resized;
+    size_t index;
+
+    *created = 0;
+    for ( index = 0; index < keys->count; ++index )
+        if ( ! compare ( keys->keys + index, probe ) )
+            return keys->keys + index;
+
+    if ( keys->count == keys->capacity )
+    {
+        keys->capacity = keys->capacity ? keys->capacity * 2 : 8;
+        if ( ! ( resized = ( EnvelopeSelectionKey * ) realloc (
+                     keys->keys, keys->capacity * sizeof ( EnvelopeSelectionKey ) ) ) )
+            goto no_memory;
+        keys->keys = resized;
+    }
+
+    key = keys->keys + keys->count;
+    *key = *probe;
+    key->nested = 0;
+    if ( probe->name )
+    {
+        if ( ! ( key->name = ( char * ) malloc ( probe->namelen ? probe->namelen : 1 ) ) )
+            goto no_memory;
+        memcpy ( key->name, probe->name, probe->namelen );
+    }
+    ++keys->count;
+    *created = 1;
+    return key;
+
+no_memory:
+    PyErr_NoMemory ( );
+    return 0;
+}
+
+/* Adds a path of names/ordinals to the selection. A key that selects an
+ * entire field takes precedence over any paths beneath it. */
+static int Envelope_addSelection ( EnvelopeSelection * selection,
+                                   PyObject ** path,
+                                   Py_ssize_t length )
+{
+    EnvelopeSelectionKey probe, * key;
+    PyObject * encoded = 0;
+    int created;
+
+    probe.ordinal = 0;
+    probe.name = 0;
+    probe.namelen = 0;
+    probe.nested = 0;
+
+    if ( PyInt_Check ( path [ 0 ] ) || PyLong_Check ( path [ 0 ] ) )
+    {
+        if ( Message_parseOrdinalObject ( &probe.ordinal, path [ 0 ] ) )
+            return -1;
+        key = Envelope_getSelectionKey ( &selection->ordinals,
+                                         &probe,
+                                         Envelope_compareOrdinalKeys,
+                                         &created );
+    }
+    else if ( PyString_Check ( path [ 0 ] ) || PyUnicode_Check ( path [ 0 ] ) )
+    {
+        if ( PyUnicode_Check ( path [ 0 ] ) &&
+             ! ( encoded = PyUnicode_AsUTF8String ( path [ 0 ] ) ) )
+            return -1;
+        probe.name = PyString_AS_STRING( encoded ? encoded : path [ 0 ] );
+        probe.namelen = PyString_GET_SIZE( encoded ? encoded : path [ 0 ] );
+        key = Envelope_getSelectionKey ( &selection->names,
+                                         &probe,
+                                         Envelope_compareNameKeys,
+                                         &created );
+        Py_XDECREF( encoded );
+    }
+    else
+    {
+        exception_raise_any ( PyExc_TypeError,
+                              "Field selections must be names, ordinals or "
+                              "tuples of them" );
+        return -1;
+    }
+    if ( ! key )
+        return -1;
+
+    if ( length == 1 )
+    {
+        /* Selecting the entire field replaces any nested selection */
+        if ( key->nested )
+        {
+            Envelope_clearSelection ( key->nested );
+            free ( key->nested );
+            key->nested = 0;
+        }
+        return 0;
+    }
+
+    /* A key that already selects the entire field needs no path */
+    if ( ! ( created || key->nested ) )
+        return 0;
+    if ( created && ! ( key->nested = ( EnvelopeSelection * ) calloc (
+                                          1, sizeof ( EnvelopeSelection ) ) ) )
+    {
+        PyErr_NoMemory ( );
+        return -1;
+    }
+    return Envelope_addSelection ( key->nested, path + 1, length - 1 );
+}
+
+static int Envelope_parseSelection ( EnvelopeSelection * selection, PyObject * fields )
+{
+    PyObject * iterator, * item, * path;
+    int result = 0;
+
+    if ( ! ( iterator = PyObject_GetIter ( fields ) ) )
+        return -1;
+
+    while ( ! result && ( item = PyIter_Next ( iterator ) ) )
+    {
+        if ( PyTuple_Check ( item ) || PyList_Check ( item ) )
+        {
+            if ( ! ( path = PySequence_Fast ( item, "" ) ) )
+                result = -1;
+            else if ( ! PySequence_Fast_GET_SIZE( path ) )
+            {
+                exception_raise_any ( PyExc_ValueError,
+                                      "Field selection paths cannot be empty" );
+                result = -1;
+            }
+            else
+                result = Envelope_addSelection ( selection,
+                                                 PySequence_Fast_ITEMS( path ),
+                                                 PySequence_Fast_GET_SIZE( path ) );
+            Py_XDECREF( path );
+        }
+        else
+            result = Envelope_addSelection ( selection, &item, 1 );
+        Py_DECREF( item );
+    }
+    Py_DECREF( iterator );
+
+    if ( result || PyErr_Occurred ( ) )
+        return -1;
+    Envelope_sortSelection ( selection );
+    return 0;
+}
+
+/* Looks up an encoded field's ordinal and name in a selection. Returns 1 if
+ * either selects the entire field; otherwise returns 0 and appends any
+ * nested selections they have to nested. */
+static int Envelope_matchSelection ( const EnvelopeSelection * selection,
+                                     const WireField * field,
+                                     const EnvelopeSelection ** nested,
+                                     size_t * numnested )
+{
+    const EnvelopeSelectionKey * key;
+    EnvelopeSelectionKey probe;
+
+    if ( field->hasordinal && selection->ordinals.count )
+    {
+        probe.ordinal = field->ordinal;
+        if ( ( key = ( const EnvelopeSelectionKey * ) bsearch (
+                         &probe,
+                         selection->ordinals.keys,
+                         selection->ordinals.count,
+                         sizeof ( EnvelopeSelectionKey ),
+                         Envelope_compareOrdinalKeys ) ) )
+        {
+            if ( ! key->nested )
+                return 1;
+            nested [ ( *numnested )++ ] = key->nested;
+        }
+    }
+    if ( field->name && selection->names.count )
+    {
+        probe.name = ( char * ) field->name;
+        probe.namelen = field->namelen;
+        if ( ( key = ( const EnvelopeSelectionKey * ) bsearch (
+                         &probe,
+                         selection->names.keys,
+                         selection->names.count,
+                         sizeof ( EnvelopeSelectionKey ),
+                         Envelope_compareNameKeys ) ) )
+        {
+            if ( ! key->nested )
+                return 1;
+            nested [ ( *numnested )++ ] = key->nested;
+        }
+    }
+    return 0;
+}
+
+/* Copies the encoded fields that match any of the selections in to the
+ * output, skipping over the others. A sub-message matched by paths (which
+ * may come from both its ordinal and its name) is filtered by all of them
+ * and re-encoded with its new width. Runs without the GIL. */
+static WireStatus Envelope_filterFields ( EnvelopeOutput * output,
+                                          const EnvelopeSelection * const * selections,
+                                          size_t numselections,
+                                          const fudge_byte * bytes,
+                                          size_t numbytes )
+{
+    fudge_byte header [ WIRE_MAX_FIELD_HEADER ];
+    const EnvelopeSelection * stacknested [ 8 ], ** nested = stacknested;
+    EnvelopeOutput child;
+    WireField field;
+    WireStatus status = WIRE_OK;
+    size_t offset = 0, numnested, index;
+    int whole;
+
+    /* Each selection contributes at most two nested selections per field */
+    if ( numselections * 2 > sizeof ( stacknested ) / sizeof ( stacknested [ 0 ] ) &&
+         ! ( nested = ( const EnvelopeSelection ** ) malloc (
+                          numselections * 2 * sizeof ( EnvelopeSelection * ) ) ) )
+        return WIRE_NO_MEMORY;
+
+    while ( status == WIRE_OK && offset < numbytes )
+    {
+        if ( ( status = wire_readField ( &field, bytes + offset, numbytes - offset ) ) != WIRE_OK )
+            break;
+
+        whole = 0;
+        numnested = 0;
+        for ( index = 0; index < numselections && ! whole; ++index )
+            whole = Envelope_matchSelection ( selections [ index ], &field, nested, &numnested );
+
+        if ( whole )
+            status = EnvelopeOutput_append ( output, bytes + offset, field.length );
+        else if ( numnested && field.type == FUDGE_TYPE_FUDGE_MSG )
+        {
+            child.bytes = 0;
+            child.size = child.capacity = 0;
+
+            status = Envelope_filterFields ( &child,
+                                             nested,
+                                             numnested,
+                                             field.payload,
+                                             field.numbytes );
+            if ( status == WIRE_OK )
+                status = EnvelopeOutput_append (
+                    output,
+                    header,
+                    wire_writeFieldHeader ( header,
+                                            &field,
+                                            bytes + offset,
+                                            ( fudge_i32 ) child.size ) );
+            if ( status == WIRE_OK && child.size )
+                status = EnvelopeOutput_append ( output, child.bytes, child.size );
+            free ( child.bytes );
+        }
+
+        offset += field.length;
+    }
+
+    if ( nested != stacknested )
+        free ( nested );
+    return status;
+}
+
+/* Builds a copy of the envelope in output that contains only the selected
+ * fields. The envelope header must already have been validated. Runs
+ * without the GIL. */
+static WireStatus Envelope_filter ( EnvelopeOutput * output,
+                                    const EnvelopeSelection * selection,
+                                    const fudge_byte * bytes,
+                                    size_t numbytes )
+{
+    WireStatus status;
+
+    if ( ( status = EnvelopeOutput_append ( output, bytes, WIRE_HEADER_SIZE ) ) != WIRE_OK ||
+         ( status = Envelope_filterFields ( output,
+                                            &selection,
+                                            1,
+                                            bytes + WIRE_HEADER_SIZE,
+                                            numbytes - WIRE_HEADER_SIZE ) ) != WIRE_OK )
+        return status;
+
+    wire_writeEnvelopeSize ( output->bytes, ( fudge_i32 ) output->size );
+    return WIRE_OK;
+}
+
 static const char DOC_fudgepyc_envelope_decode [] =
     "\nDecode an encoded Fudge envelope\n\n"
-    "Note that this method will release the GIL during decoding.\n\n"
+    "If fields is provided, only the fields it selects are decoded; the\n"
+    "payloads of all other fields are skipped without being decoded. It is a\n"
+    "collection of field names, ordinals and paths; a path is a tuple of\n"
+    "names/ordinals that selects fields within sub-messages, so (\"a\", 1)\n"
+    "selects the fields with ordinal 1 within the sub-message \"a\". Selected\n"
+    "sub-messages are otherwise decoded in their entirety. A sub-message\n"
+    "with both a name and an ordinal is filtered by the paths through\n"
+    "either. Ordinals must be in the range 0-32767.\n\n"
+    "If asciistr is True, the values of String fields that only contain ASCII\n"
+    "characters are returned as str rather than Unicode.\n\n"
+    "If epochnanos is True, the values of Date, Time and DateTime fields are\n"
+    "returned as integer nanoseconds (see Field.getEpochNanos) rather than as\n"
+    "datetime objects.\n\n"
+    "Note that this method will release the GIL during filtering and\n"
+    "decoding.\n\n"
     "@param bytes: buffer object (e.g. String) containing the encoded envelope\n"
+    "@param fields: collection of names/ordinals/paths of fields to decode,\n"
+    "               defaults to None (i.e. decode all fields)\n"
+    "@param epochnanos: if True, return date/time values as nanoseconds,\n"
+    "                   defaults to False\n"
+    "@param asciistr: if True, return ASCII-only strings as str, defaults to\n"
+    "                 False\n"
     "@return: the decoded Envelope\n";
 PyObject * Envelope_decode ( PyTypeObject * type, PyObject * args, PyObject * kwds )
 {
-    static char * kwlist [] = { "bytes", 0 };
+    static char * kwlist [] = { "bytes", "fields", "epochnanos", "asciistr", 0 };
 
-    PyObject * target;
-    FudgeStatus status;
+    EnvelopeSelection selection = { { 0, 0, 0 }, { 0, 0, 0 } };
+    EnvelopeOutput output = { 0, 0, 0 };
+    PyObject * target = 0, * fields = Py_None;
+    FudgeStatus status = FUDGE_OK;
+    WireStatus wirestatus = WIRE_OK;
     FudgeMsgEnvelope envlpe;
+    WireHeader header;
     const void * bytes;
     Py_ssize_t numbytes;
     PyObject * buffer;
+    int epochnanos = 0, asciistr = 0;
 
-    if ( ! PyArg_ParseTupleAndKeywords ( args, kwds, "O", kwlist, &buffer ) )
+    if ( ! PyArg_ParseTupleAndKeywords ( args, kwds, "O|Oii", kwlist,
+                                         &buffer, &fields,
+                                         &epochnanos, &asciistr ) )
         return 0;
     if ( ! PyObject_CheckReadBuffer ( buffer ) )
     {
@@ -181,19 +875,251 @@ PyObject * Envelope_decode ( PyTypeObject * type, PyObject * args, PyObject * kw
     if ( PyObject_AsReadBuffer ( buffer, &bytes, &numbytes ) )
         return 0;
 
+    if ( fields != Py_None )
+    {
+        if ( wire_readHeader ( &header, bytes, ( size_t ) numbytes ) != WIRE_OK ||
+             header.size > numbytes )
+        {
+            exception_raise_any ( FudgePyc_Exception,
+                                  "Malformed or truncated envelope header" );
+            return 0;
+        }
+        if ( Envelope_parseSelection ( &selection, fields ) )
+            goto clean_and_return;
+    }
+
+    /* For a selective decode, the selected fields are copied in to a new
+       envelope which is then decoded in place of the original */
     Py_BEGIN_ALLOW_THREADS
-    status = FudgeCodec_decodeMsg ( &envlpe, bytes, ( fudge_i32 ) numbytes );
+    if ( fields != Py_None &&
+         ( wirestatus = Envelope_filter ( &output,
+                                          &selection,
+                                          ( const fudge_byte * ) bytes,
+                                          ( size_t ) header.size ) ) == WIRE_OK )
+    {
+        bytes = output.bytes;
+        numbytes = ( Py_ssize_t ) output.size;
+    }
+    if ( wirestatus == WIRE_OK )
+        status = FudgeCodec_decodeMsg ( &envlpe, bytes, ( fudge_i32 ) numbytes );
     Py_END_ALLOW_THREADS
 
+    if ( wirestatus == WIRE_NO_MEMORY )
+    {
+        PyErr_NoMemory ( );
+        goto clean_and_return;
+    }
+    if ( wirestatus != WIRE_OK )
+    {
+        exception_raise_any ( FudgePyc_Exception,
+                              "Malformed field encoding in envelope" );
+        goto clean_and_return;
+    }
     if ( exception_raiseOnError ( status ) )
-        return 0;
+        goto clean_and_return;
 
     target = Envelope_create ( envlpe );
     FudgeMsgEnvelope_release ( envlpe );
+    if ( target )
+    {
+        Message * message = ( Message * ) ( ( Envelope * ) target )->message;
+        message->epochnanos = epochnanos;
+        message->asciistr = asciistr;
+    }
+
+clean_and_return:
+    free ( output.bytes );
+    Envelope_clearSelection ( &selection );
     return target;
 }
 
 
+static const char DOC_fudgepyc_envelope_decodeMany [] =
+    "\nDecode a sequence of back-to-back encoded Fudge envelopes, such as the\n"
+    "contents of a capture file or a batch of socket reads. Decoding stops at\n"
+    "the end of the buffer, at an incomplete trailing envelope or once limit\n"
+    "envelopes have been decoded. The number of bytes consumed can be used\n"
+    "as the offset for the next call.\n\n"
+    "Note that this method will release the GIL during decoding.\n\n"
+    "@param buffer: buffer object (e.g. String) containing the envelopes\n"
+    "@param offset: byte offset within the buffer to start at, defaults to 0\n"
+    "@param limit: maximum number of envelopes to decode, defaults to None\n"
+    "              (i.e. no limit)\n"
+    "@return: tuple of ( list of Envelopes, number of bytes consumed )\n";
+PyObject * Envelope_decodeMany ( PyTypeObject * type, PyObject * args, PyObject * kwds )
+{
+    static char * kwlist [] = { "buffer", "offset", "limit", 0 };
+
+    PyObject * buffer, * pylimit = Py_None, * envelopes = 0, * envobj;
+    const void * bytes;
+    Py_ssize_t numbytes, offset = 0, limit = -1, index;
+    FudgeMsgEnvelope * decoded = 0, * resized;
+    size_t numdecoded = 0, capacity = 0, consumed;
+    FudgeStatus status = FUDGE_OK;
+    WireStatus wirestatus = WIRE_OK;
+    WireHeader header;
+
+    if ( ! PyArg_ParseTupleAndKeywords ( args, kwds, "O|nO", kwlist,
+                                         &buffer, &offset, &pylimit ) )
+        return 0;
+    if ( pylimit != Py_None )
+    {
+        if ( ( limit = PyNumber_AsSsize_t ( pylimit, PyExc_OverflowError ) ) == -1 &&
+             PyErr_Occurred ( ) )
+            return 0;
+        if ( limit < 0 )
+        {
+            exception_raise_any ( PyExc_ValueError, "Limit cannot be negative" );
+            return 0;
+        }
+    }
+    if ( ! PyObject_CheckReadBuffer ( buffer ) )
+    {
+        exception_raise_any ( PyExc_TypeError,
+                              "Cannot decode object that doesn't implement "
+                              "the Buffer protocol (e.g. String)" );
+        return 0;
+    }
+    if ( PyObject_AsReadBuffer ( buffer, &bytes, &numbytes ) )
+        return 0;
+    if ( offset < 0 || offset > numbytes )
+    {
+        exception_raise_any ( PyExc_IndexError,
+                              "Offset %zd is outside of the %zd byte buffer",
+                              offset, numbytes );
+        return 0;
+    }
+
+    /* Frame and decode every envelope without returning to Python; the
+       results are held in a plain C array until the GIL is reacquired */
+    consumed = ( size_t ) offset;
+    Py_BEGIN_ALLOW_THREADS
+    while ( limit < 0 || numdecoded < ( size_t ) limit )
+    {
+        if ( ( wirestatus = wire_readHeader ( &header,
+                                              ( const fudge_byte * ) bytes + consumed,
+                                              numbytes - consumed ) ) != WIRE_OK )
+            break;
+        if ( ( size_t ) header.size > numbytes - consumed )
+            break;
+
+        if ( numdecoded == capacity )
+        {
+            capacity = capacity ? capacity * 2 : 64;
+            if ( ! ( resized = ( FudgeMsgEnvelope * ) realloc (
+                         decoded, capacity * sizeof ( FudgeMsgEnvelope ) ) ) )
+            {
+                status = FUDGE_OUT_OF_MEMORY;
+                break;
+            }
+            decoded = resized;
+        }
+
+        if ( ( status = FudgeCodec_decodeMsg ( decoded + numdecoded,
+                                               ( const fudge_byte * ) bytes + consumed,
+                                               header.size ) ) != FUDGE_OK )
+            break;
+        ++numdecoded;
+        consumed += header.size;
+    }
+    Py_END_ALLOW_THREADS
+
+    if ( exception_raiseOnError ( status ) )
+        goto release_envelopes_and_return;
+    if ( wirestatus == WIRE_MALFORMED )
+    {
+        exception_raise_any ( FudgePyc_Exception,
+                              "Invalid envelope size %d at offset %zu",
+                              header.size, consumed );
+        goto release_envelopes_and_return;
+    }
+
+    if ( ! ( envelopes = PyList_New ( numdecoded ) ) )
+        goto release_envelopes_and_return;
+    for ( index = 0; index < ( Py_ssize_t ) numdecoded; ++index )
+    {
+        if ( ! ( envobj = Envelope_create ( decoded [ index ] ) ) )
+        {
+            Py_CLEAR( envelopes );
+            goto release_envelopes_and_return;
+        }
+        PyList_SET_ITEM( envelopes, index, envobj );
+    }
+
+release_envelopes_and_return:
+    for ( index = 0; index < ( Py_ssize_t ) numdecoded; ++index )
+        FudgeMsgEnvelope_release ( decoded [ index ] );
+    free ( decoded );
+
+    if ( ! envelopes )
+        return 0;
+    return Py_BuildValue ( "Nn", envelopes, ( Py_ssize_t ) ( consumed - offset ) );
+}
+
+
+static const char DOC_fudgepyc_envelope_peekHeader [] =
+    "\nRead the header of an encoded Fudge envelope without decoding its\n"
+    "message, e.g. to route an envelope on its schema version or taxonomy.\n\n"
+    "@param buffer: buffer object (e.g. String) containing the envelope\n"
+    "@param offset: byte offset of the envelope in the buffer, defaults to 0\n"
+    "@return: tuple of ( directives, schema, taxonomy, size ) where size is\n"
+    "         the total encoded size of the envelope, header included\n";
+PyObject * Envelope_peekHeader ( PyTypeObject * type, PyObject * args, PyObject * kwds )
+{
+    static char * kwlist [] = { "buffer", "offset", 0 };
+
+    PyObject * buffer;
+    const void * bytes;
+    Py_ssize_t numbytes, offset = 0;
+    WireHeader header;
+
+    if ( ! PyArg_ParseTupleAndKeywords ( args, kwds, "O|n", kwlist,
+                                         &buffer, &offset ) )
+        return 0;
+    if ( ! PyObject_CheckReadBuffer ( buffer ) )
+    {
+        exception_raise_any ( PyExc_TypeError,
+                              "Cannot read header from object that doesn't "
+                              "implement the Buffer protocol (e.g. String)" );
+        return 0;
+    }
+    if ( PyObject_AsReadBuffer ( buffer, &bytes, &numbytes ) )
+        return 0;
+    if ( offset < 0 || offset > numbytes )
+    {
+        exception_raise_any ( PyExc_IndexError,
+                              "Offset %zd is outside of the %zd byte buffer",
+                              offset, numbytes );
+        return 0;
+    }
+
+    switch ( wire_readHeader ( &header,
+                               ( const fudge_byte * ) bytes + offset,
+                               numbytes - offset ) )
+    {
+        case WIRE_OK:
+            break;
+        case WIRE_TRUNCATED:
+            exception_raise_any ( FudgePyc_Exception,
+                                  "Buffer too small for envelope header; "
+                                  "%d bytes required but only %zd available",
+                                  WIRE_HEADER_SIZE, numbytes - offset );
+            return 0;
+        default:
+            exception_raise_any ( FudgePyc_Exception,
+                                  "Invalid envelope size %d in header",
+                                  header.size );
+            return 0;
+    }
+
+    return Py_BuildValue ( "iiil",
+                           ( int ) header.directives,
+                           ( int ) header.schema,
+                           ( int ) header.taxonomy,
+                           ( long ) header.size );
+}
+
+
 /****************************************************************************
  * Type and method list definitions
  */
@@ -205,8 +1131,15 @@ static PyMethodDef Envelope_methods [] =
     { "taxonomy",   ( PyCFunction ) Envelope_taxonomy,   METH_NOARGS, DOC_fudgepyc_envelope_taxonomy },
     { "message",    ( PyCFunction ) Envelope_message,    METH_NOARGS, DOC_fudgepyc_envelope_message },
     { "encode",     ( PyCFunction ) Envelope_encode,     METH_NOARGS, DOC_fudgepyc_envelope_encode },
+    { "encodeInto", ( PyCFunction ) Envelope_encodeInto, METH_VARARGS | METH_KEYWORDS, DOC_fudgepyc_envelope_encodeInto },
+    { "encodedSize", ( PyCFunction ) Envelope_encodedSize, METH_NOARGS, DOC_fudgepyc_envelope_encodedSize },
+
+    { "encodeMany",     ( PyCFunction ) Envelope_encodeMany,     METH_VARARGS | METH_KEYWORDS | METH_CLASS , DOC_fudgepyc_envelope_encodeMany },
+    { "encodeManyInto", ( PyCFunction ) Envelope_encodeManyInto, METH_VARARGS | METH_KEYWORDS | METH_CLASS , DOC_fudgepyc_envelope_encodeManyInto },
 
     { "decode",     ( PyCFunction ) Envelope_decode,     METH_VARARGS | METH_KEYWORDS | METH_CLASS , DOC_fudgepyc_envelope_decode },
+    { "decodeMany", ( PyCFunction ) Envelope_decodeMany, METH_VARARGS | METH_KEYWORDS | METH_CLASS , DOC_fudgepyc_envelope_decodeMany },
+    { "peekHeader", ( PyCFunction ) Envelope_peekHeader, METH_VARARGS | METH_KEYWORDS | METH_CLASS , DOC_fudgepyc_envelope_peekHeader },
     { NULL }
 };
 
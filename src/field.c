@@ -147,51 +147,29 @@ size_t Field_len ( Field * self )
     }
 }
 
-static const char DOC_fudgepyc_field_value [] =
-"\nGet the Field's value as a Python object. The Fudge field types map to\n"
-"Python as follows:\n"
-"\n"
-"  - Indicator: None\n"
-"  - Boolean: bool\n"
-"  - Byte: int\n"
-"  - Short: int\n"
-"  - Int: int\n"
-"  - Long: long\n"
-"  - Float: float\n"
-"  - Double: float\n"
-"  - Byte[]: String\n"
-"  - Short[]: List of int\n"
-"  - Int[]: List of int\n"
-"  - Long[]: List of long\n"
-"  - Float[]: List of float\n"
-"  - Double[]: List fo double\n"
-"  - String: Unicode\n"
-"  - FudgeMsg: fudgepyc.Message\n"
-"  - Date: datetime.date\n"
-"  - Time: datetime.time\n"
-"  - DateTime: datetime.datetime\n"
-"\n"
-"@return: Python object containing the Field value\n";
-PyObject * Field_value ( Field * self )
+PyObject * Field_convertValue ( const FudgeField * field,
+                                const FieldValueOptions * options,
+                                FieldMessageConverter convertmsg,
+                                void * context )
 {
-    switch ( self->field.type )
+    switch ( field->type )
     {
         case FUDGE_TYPE_INDICATOR:
             Py_RETURN_NONE;
         case FUDGE_TYPE_BOOLEAN:
-            return fudgepyc_convertBoolToPython ( self->field.data.boolean );
+            return fudgepyc_convertBoolToPython ( field->data.boolean );
         case FUDGE_TYPE_BYTE:
-            return fudgepyc_convertByteToPython ( self->field.data.byte );
+            return fudgepyc_convertByteToPython ( field->data.byte );
         case FUDGE_TYPE_SHORT:
-            return fudgepyc_convertI16ToPython ( self->field.data.i16 );
+            return fudgepyc_convertI16ToPython ( field->data.i16 );
         case FUDGE_TYPE_INT:
-            return fudgepyc_convertI32ToPython ( self->field.data.i32 );
+            return fudgepyc_convertI32ToPython ( field->data.i32 );
         case FUDGE_TYPE_LONG:
-            return fudgepyc_convertI64ToPython ( self->field.data.i64 );
+            return fudgepyc_convertI64ToPython ( field->data.i64 );
         case FUDGE_TYPE_FLOAT:
-            return fudgepyc_convertF32ToPython ( self->field.data.f32 );
+            return fudgepyc_convertF32ToPython ( field->data.f32 );
         case FUDGE_TYPE_DOUBLE:
-            return fudgepyc_convertF64ToPython ( self->field.data.f64 );
+            return fudgepyc_convertF64ToPython ( field->data.f64 );
 
         case FUDGE_TYPE_BYTE_ARRAY:
         case FUDGE_TYPE_BYTE_ARRAY_4:
@@ -203,46 +181,113 @@ PyObject * Field_value ( Field * self )
         case FUDGE_TYPE_BYTE_ARRAY_128:
         case FUDGE_TYPE_BYTE_ARRAY_256:
         case FUDGE_TYPE_BYTE_ARRAY_512:
-            return fudgepyc_convertByteStringToPython ( self->field.data.bytes,
-                                                        self->field.numbytes );
+            return fudgepyc_convertByteStringToPython ( field->data.bytes,
+                                                        field->numbytes );
 
         case FUDGE_TYPE_SHORT_ARRAY:
-            return fudgepyc_convertI16ArrayToPython ( self->field.data.bytes,
-                                                      self->field.numbytes );
+            return fudgepyc_convertI16ArrayToPython ( field->data.bytes,
+                                                      field->numbytes );
         case FUDGE_TYPE_INT_ARRAY:
-            return fudgepyc_convertI32ArrayToPython ( self->field.data.bytes,
-                                                      self->field.numbytes );
+            return fudgepyc_convertI32ArrayToPython ( field->data.bytes,
+                                                      field->numbytes );
         case FUDGE_TYPE_LONG_ARRAY:
-            return fudgepyc_convertI64ArrayToPython ( self->field.data.bytes,
-                                                      self->field.numbytes );
+            return fudgepyc_convertI64ArrayToPython ( field->data.bytes,
+                                                      field->numbytes );
         case FUDGE_TYPE_FLOAT_ARRAY:
-            return fudgepyc_convertF32ArrayToPython ( self->field.data.bytes,
-                                                      self->field.numbytes );
+            return fudgepyc_convertF32ArrayToPython ( field->data.bytes,
+                                                      field->numbytes );
         case FUDGE_TYPE_DOUBLE_ARRAY:
-            return fudgepyc_convertF64ArrayToPython ( self->field.data.bytes,
-                                                      self->field.numbytes );
+            return fudgepyc_convertF64ArrayToPython ( field->data.bytes,
+                                                      field->numbytes );
 
         case FUDGE_TYPE_STRING:
-            return fudgepyc_convertStringToPython ( self->field.data.string );
+            if ( options->asciistr )
+                return fudgepyc_convertStringToPythonAscii ( field->data.string );
+            return fudgepyc_convertStringToPython ( field->data.string );
 
         case FUDGE_TYPE_FUDGE_MSG:
-            return Message_retrieveMessage ( self->parent,
-                                             self->field.data.message );
+            return convertmsg ( field->data.message, context );
 
         case FUDGE_TYPE_DATE:
-            return fudgepyc_convertDateToPython ( &self->field.data.datetime.date );
+            if ( options->epochnanos )
+                return fudgepyc_convertDateToPythonEpoch (
+                           ( FudgeDate * ) &field->data.datetime.date );
+            return fudgepyc_convertDateToPython (
+                       ( FudgeDate * ) &field->data.datetime.date );
         case FUDGE_TYPE_TIME:
-            return fudgepyc_convertTimeToPython ( &self->field.data.datetime.time );
+            if ( options->epochnanos )
+                return fudgepyc_convertTimeToPythonEpoch (
+                           ( FudgeTime * ) &field->data.datetime.time );
+            return fudgepyc_convertTimeToPython (
+                       ( FudgeTime * ) &field->data.datetime.time );
         case FUDGE_TYPE_DATETIME:
-            return fudgepyc_convertDateTimeToPython ( &self->field.data.datetime );
+            if ( options->epochnanos )
+                return fudgepyc_convertDateTimeToPythonEpoch (
+                           ( FudgeDateTime * ) &field->data.datetime );
+            return fudgepyc_convertDateTimeToPython (
+                       ( FudgeDateTime * ) &field->data.datetime );
 
         default:
             /* If in doubt - return a bundle of bytes */
-            return fudgepyc_convertByteStringToPython ( self->field.data.bytes,
-                                                        self->field.numbytes );
+            return fudgepyc_convertByteStringToPython ( field->data.bytes,
+                                                        field->numbytes );
     }
 }
 
+static PyObject * Field_retrieveMessage ( FudgeMsg message, void * parent )
+{
+    return Message_retrieveMessage ( ( Message * ) parent, message );
+}
+
+PyObject * Field_convertMessageValue ( const FudgeField * field, Message * parent )
+{
+    FieldValueOptions options;
+
+    options.epochnanos = parent && parent->epochnanos;
+    options.asciistr = parent && parent->asciistr;
+    return Field_convertValue ( field, &options, Field_retrieveMessage, parent );
+}
+
+static const char DOC_fudgepyc_field_value [] =
+"\nGet the Field's value as a Python object. The Fudge field types map to\n"
+"Python as follows:\n"
+"\n"
+"  - Indicator: None\n"
+"  - Boolean: bool\n"
+"  - Byte: int\n"
+"  - Short: int\n"
+"  - Int: int\n"
+"  - Long: long\n"
+"  - Float: float\n"
+"  - Double: float\n"
+"  - Byte[]: String\n"
+"  - Short[]: List of int\n"
+"  - Int[]: List of int\n"
+"  - Long[]: List of long\n"
+"  - Float[]: List of float\n"
+"  - Double[]: List fo double\n"
+"  - String: Unicode\n"
+"  - FudgeMsg: fudgepyc.Message\n"
+"  - Date: datetime.date\n"
+"  - Time: datetime.time\n"
+"  - DateTime: datetime.datetime\n"
+"\n"
+"If the Message was decoded with asciistr set, Strings that only contain\n"
+"ASCII characters are returned as str rather than Unicode.\n"
+"\n"
+"If the Message was decoded with epochnanos set, Date, Time and DateTime\n"
+"values are instead returned as integer nanoseconds; see getEpochNanos.\n"
+"\n"
+"Use Field.asBuffer to read large arrays without creating a Python\n"
+"object per element.\n"
+"\n"
+"@return: Python object containing the Field value\n";
+PyObject * Field_value ( Field * self )
+{
+    return Field_convertMessageValue ( &self->field, self->parent );
+}
+
+
 static const char DOC_fudgepyc_field_name [] =
     "\nGet the Field's name, if it has one\n\n"
     "@return: String containing the Field name, or None if not present\n";
@@ -387,6 +432,34 @@ PyObject * Field_getRawDateTime ( Field * self )
     return 0;
 }
 
+static const char DOC_fudgepyc_field_getEpochNanos [] =
+    "\nGet the Field value as an integer count of nanoseconds, if it is of Fudge\n"
+    "type Date, Time or DateTime. This keeps the full nanosecond precision\n"
+    "that datetime.datetime and datetime.time truncate to microseconds.\n\n"
+    "  - Date: nanoseconds from the Unix epoch to midnight UTC on that day\n"
+    "  - Time: nanoseconds since midnight, ignoring any timezone\n"
+    "  - DateTime: nanoseconds since the Unix epoch (1970-01-01 00:00:00 UTC);\n"
+    "              a timezone, if present, is applied to get the UTC instant\n\n"
+    "@return: long, or fudgepyc.Exception if of incorrect type\n";
+PyObject * Field_getEpochNanos ( Field * self )
+{
+    switch ( self->field.type )
+    {
+        case FUDGE_TYPE_DATE:
+            return fudgepyc_convertDateToPythonEpoch (
+                       &self->field.data.datetime.date );
+        case FUDGE_TYPE_TIME:
+            return fudgepyc_convertTimeToPythonEpoch (
+                       &self->field.data.datetime.time );
+        case FUDGE_TYPE_DATETIME:
+            return fudgepyc_convertDateTimeToPythonEpoch (
+                       &self->field.data.datetime );
+    }
+    exception_raise_any ( FudgePyc_Exception,
+                          "Invalid conversion to epoch nanoseconds" );
+    return 0;
+}
+
 static const char DOC_fudgepyc_field_getByteArray [] =
     "\nGet the field value as a [int, ...], if it is a byte array (either\n"
     "fixed or variable width. To get the bytes as a String, use\n"
@@ -588,6 +661,143 @@ clear_string_and_fail:
     return 0;
 }
 
+/****************************************************************************
+ * Buffer protocol implementation
+ */
+
+/* Returns the struct module format code for the elements of an array
+ * type and sets itemsize, or returns null if the type is not an array.
+ * Fudge holds array elements in native byte order. */
+static const char * Field_getBufferFormat ( fudge_type_id type, Py_ssize_t * itemsize )
+{
+    switch ( type )
+    {
+        case FUDGE_TYPE_SHORT_ARRAY:
+            *itemsize = sizeof ( fudge_i16 );
+            return "h";
+        case FUDGE_TYPE_INT_ARRAY:
+            *itemsize = sizeof ( fudge_i32 );
+            return sizeof ( int ) == sizeof ( fudge_i32 ) ? "i" : "l";
+        case FUDGE_TYPE_LONG_ARRAY:
+            *itemsize = sizeof ( fudge_i64 );
+            return "q";
+        case FUDGE_TYPE_FLOAT_ARRAY:
+            *itemsize = sizeof ( fudge_f32 );
+            return "f";
+        case FUDGE_TYPE_DOUBLE_ARRAY:
+            *itemsize = sizeof ( fudge_f64 );
+            return "d";
+
+        case FUDGE_TYPE_BYTE_ARRAY:
+        case FUDGE_TYPE_BYTE_ARRAY_4:
+        case FUDGE_TYPE_BYTE_ARRAY_8:
+        case FUDGE_TYPE_BYTE_ARRAY_16:
+        case FUDGE_TYPE_BYTE_ARRAY_20:
+        case FUDGE_TYPE_BYTE_ARRAY_32:
+        case FUDGE_TYPE_BYTE_ARRAY_64:
+        case FUDGE_TYPE_BYTE_ARRAY_128:
+        case FUDGE_TYPE_BYTE_ARRAY_256:
+        case FUDGE_TYPE_BYTE_ARRAY_512:
+            *itemsize = sizeof ( fudge_byte );
+            return "b";
+
+        default:
+            return 0;
+    }
+}
+
+/* Returns a pointer to the field's array payload and sets numbytes, or
+ * returns null with a TypeError set if the field is not an array */
+static void * Field_getBufferBytes ( Field * self, Py_ssize_t * numbytes )
+{
+    static fudge_byte empty [ 1 ];
+    Py_ssize_t itemsize;
+
+    if ( ! Field_getBufferFormat ( self->field.type, &itemsize ) )
+    {
+        exception_raise_any ( PyExc_TypeError,
+                              "Only array fields support the buffer interface" );
+        return 0;
+    }
+
+    *numbytes = self->field.numbytes;
+    return self->field.numbytes ? ( void * ) self->field.data.bytes : empty;
+}
+
+static Py_ssize_t Field_getreadbuffer ( Field * self, Py_ssize_t segment, void * * ptr )
+{
+    Py_ssize_t numbytes;
+
+    if ( segment )
+    {
+        exception_raise_any ( PyExc_SystemError, "Accessing non-existent Field segment" );
+        return -1;
+    }
+    if ( ! ( *ptr = Field_getBufferBytes ( self, &numbytes ) ) )
+        return -1;
+    return numbytes;
+}
+
+/* Non-array fields have no segments, so PyObject_CheckReadBuffer agrees
+ * with Field_getbuffer about which fields are buffers */
+static Py_ssize_t Field_getsegcount ( Field * self, Py_ssize_t * lenp )
+{
+    Py_ssize_t itemsize;
+
+    if ( ! Field_getBufferFormat ( self->field.type, &itemsize ) )
+    {
+        if ( lenp )
+            *lenp = 0;
+        return 0;
+    }
+
+    if ( lenp )
+        *lenp = self->field.numbytes;
+    return 1;
+}
+
+/* The field's bytes belong to the parent Message, which the Field keeps
+ * alive; the buffer is read-only as Fudge messages cannot be modified */
+static int Field_getbuffer ( Field * self, Py_buffer * view, int flags )
+{
+    const char * format;
+    Py_ssize_t numbytes;
+    void * bytes;
+
+    if ( ! ( bytes = Field_getBufferBytes ( self, &numbytes ) ) )
+        return -1;
+    if ( PyBuffer_FillInfo ( view, ( PyObject * ) self, bytes, numbytes, 1, flags ) )
+        return -1;
+
+    /* FillInfo describes a byte buffer, which is left as it is for simple
+       consumers; re-describe it as typed elements for those that asked for
+       a format or shape */
+    if ( ! ( flags & PyBUF_FORMAT ) && ( flags & PyBUF_ND ) != PyBUF_ND )
+        return 0;
+
+    format = Field_getBufferFormat ( self->field.type, &view->itemsize );
+    self->bufshape = numbytes / view->itemsize;
+    if ( flags & PyBUF_FORMAT )
+        view->format = ( char * ) format;
+    if ( ( flags & PyBUF_ND ) == PyBUF_ND )
+        view->shape = &self->bufshape;
+    return 0;
+}
+
+static const char DOC_fudgepyc_field_asBuffer [] =
+    "\nGet a read-only memoryview of an array field's elements, without\n"
+    "converting them to Python objects. The view's format is the struct\n"
+    "module code for the element type (Byte[] and fixed width byte arrays\n"
+    "are \"b\") and elements are in native byte order. The view keeps the\n"
+    "Field, and so its parent Message, alive.\n\n"
+    "Field itself supports the buffer interface, so can also be passed\n"
+    "directly to buffer, memoryview or numpy.frombuffer.\n\n"
+    "@return: memoryview, or TypeError if not an array field\n";
+PyObject * Field_asBuffer ( Field * self )
+{
+    return PyMemoryView_FromObject ( ( PyObject * ) self );
+}
+
 /****************************************************************************
  * Type and method list definitions
  */
@@ -618,6 +828,7 @@ static PyMethodDef Field_methods [] =
     { "getRawDate",      ( PyCFunction ) Field_getRawDate,     METH_NOARGS, DOC_fudgepyc_field_getRawDate },
     { "getRawTime",      ( PyCFunction ) Field_getRawTime,     METH_NOARGS, DOC_fudgepyc_field_getRawTime },
     { "getRawDateTime",  ( PyCFunction ) Field_getRawDateTime, METH_NOARGS, DOC_fudgepyc_field_getRawDateTime },
+    { "getEpochNanos",   ( PyCFunction ) Field_getEpochNanos,  METH_NOARGS, DOC_fudgepyc_field_getEpochNanos },
 
     { "getByteArray",    ( PyCFunction ) Field_getByteArray,   METH_NOARGS, DOC_fudgepyc_field_getByteArray },
     { "getInt16Array",   ( PyCFunction ) Field_getI16Array,    METH_NOARGS, DOC_fudgepyc_field_getI16Array },
@@ -635,6 +846,7 @@ static PyMethodDef Field_methods [] =
     { "getAsFloat64",    ( PyCFunction ) Field_getAsF64,       METH_NOARGS, DOC_fudgepyc_field_getAsF64 },
 
     { "value",           ( PyCFunction ) Field_value,          METH_NOARGS, DOC_fudgepyc_field_value },
+    { "asBuffer",        ( PyCFunction ) Field_asBuffer,       METH_NOARGS, DOC_fudgepyc_field_asBuffer },
     { NULL }
 };
 
@@ -652,6 +864,16 @@ PySequenceMethods Field_as_sequence =
     0                                       /* sq_inplace_repeat */
 };
 
+PyBufferProcs Field_as_buffer =
+{
+    ( readbufferproc ) Field_getreadbuffer, /* bf_getreadbuffer */
+    0,                                      /* bf_getwritebuffer */
+    ( segcountproc ) Field_getsegcount,     /* bf_getsegcount */
+    0,                                      /* bf_getcharbuffer */
+    ( getbufferproc ) Field_getbuffer,      /* bf_getbuffer */
+    0                                       /* bf_releasebuffer */
+};
+
 PyNumberMethods Field_as_number =
 {
     0,                                      /* nb_add */
@@ -716,8 +938,9 @@ PyTypeObject FieldType =
     ( reprfunc ) &Field_str,                        /* tp_str */
     0,                                              /* tp_getattro */
     0,                                              /* tp_setattro */
-    0,                                              /* tp_as_buffer */
-    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE,       /* tp_flags */
+    &Field_as_buffer,                               /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE |
+        Py_TPFLAGS_HAVE_NEWBUFFER,                  /* tp_flags */
     DOC_fudgepyc_field,                             /* tp_doc */
     0,                                              /* tp_traverse */
     0,                                              /* tp_clear */
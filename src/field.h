@@ -23,12 +23,35 @@ typedef struct
     PyObject_HEAD
     FudgeField field;
     Message * parent;
+    Py_ssize_t bufshape;    /* Element count, exported by Field_getbuffer */
 } Field;
 
 extern PyTypeObject FieldType;
 
 extern PyObject * Field_create ( FudgeField field, Message * parent );
 
+/* Decode options that change the Python form of field values */
+typedef struct
+{
+    int epochnanos;         /* Return date/time values as epoch nanoseconds */
+    int asciistr;           /* Return ASCII-only strings as str, not unicode */
+} FieldValueOptions;
+
+/* Converts the value of a sub-message field; context is passed through
+ * unchanged from Field_convertValue */
+typedef PyObject * ( *FieldMessageConverter ) ( FudgeMsg message, void * context );
+
+/* Converts the field's value to a Python object, using convertmsg for
+ * sub-messages */
+extern PyObject * Field_convertValue ( const FudgeField * field,
+                                       const FieldValueOptions * options,
+                                       FieldMessageConverter convertmsg,
+                                       void * context );
+
+/* Converts the field's value to a Python object, as Field.value does; the
+ * parent Message is used for sub-messages and decode options */
+extern PyObject * Field_convertMessageValue ( const FudgeField * field, Message * parent );
+
 extern int Field_modinit ( PyObject * module );
 
 #endif
@@ -0,0 +1,233 @@
+/**
+ * Copyright (C) 2012 - 2012, Vrai Stacey.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "fieldindex.h"
+#include <fudge/string.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* The ordinal table is only built if it would have no more than this many
+ * entries, or FIELDINDEX_ORDINAL_SPREAD entries per field */
+#define FIELDINDEX_MIN_ORDINALS     1024
+#define FIELDINDEX_ORDINAL_SPREAD   8
+
+/* FNV-1a hash of the name's UTF8 bytes */
+static size_t fieldindex_hashName ( FudgeString name )
+{
+    const unsigned char * bytes = ( const unsigned char * ) FudgeString_getData ( name );
+    size_t size = FudgeString_getSize ( name ),
+           hash = 2166136261u;
+
+    while ( size-- )
+        hash = ( hash ^ *bytes++ ) * 16777619u;
+    return hash;
+}
+
+static int fieldindex_isEqualName ( FudgeString x, FudgeString y )
+{
+    size_t size = FudgeString_getSize ( x );
+    return size == FudgeString_getSize ( y ) &&
+           ! memcmp ( FudgeString_getData ( x ), FudgeString_getData ( y ), size );
+}
+
+/* Returns the slot holding the name, or the empty slot it would occupy */
+static fudge_i32 * fieldindex_findNameSlot ( const FieldIndex * index,
+                                             FudgeString name )
+{
+    size_t mask = index->namecapacity - 1,
+           slot = fieldindex_hashName ( name ) & mask;
+
+    while ( index->names [ slot ] &&
+            ! fieldindex_isEqualName ( index->fields [ index->names [ slot ] - 1 ].name,
+                                       name ) )
+        slot = ( slot + 1 ) & mask;
+    return index->names + slot;
+}
+
+static void fieldindex_insertName ( FieldIndex * index, fudge_i32 offset )
+{
+    fudge_i32 * slot;
+
+    if ( index->fields [ offset ].flags & FUDGE_FIELD_HAS_NAME )
+    {
+        slot = fieldindex_findNameSlot ( index, index->fields [ offset ].name );
+        if ( ! *slot )
+            *slot = offset + 1;
+    }
+}
+
+/* Adds the names of the fields from offset onwards. The table is rebuilt,
+ * at double the size, if it could become more than half full. */
+static int fieldindex_addNames ( FieldIndex * index, fudge_i32 offset )
+{
+    size_t capacity = index->namecapacity ? index->namecapacity : 8;
+
+    while ( capacity < ( size_t ) index->numfields * 2 )
+        capacity <<= 1;
+
+    if ( capacity != index->namecapacity )
+    {
+        free ( index->names );
+        if ( ! ( index->names = ( fudge_i32 * ) calloc ( capacity, sizeof ( fudge_i32 ) ) ) )
+            return -1;
+        index->namecapacity = capacity;
+        offset = 0;
+    }
+
+    for ( ; offset < index->numfields; ++offset )
+        fieldindex_insertName ( index, offset );
+    return 0;
+}
+
+/* Adds the ordinals of the fields from offset onwards. The table is
+ * rebuilt, at least doubling in size, if an ordinal is beyond its end; and
+ * dropped if the ordinals are too sparse for the number of fields. */
+static int fieldindex_addOrdinals ( FieldIndex * index, fudge_i32 offset )
+{
+    fudge_i32 scan;
+    size_t ordinal, capacity, limit;
+
+    /* Ordinals are indexed as unsigned, matching lookups which accept any
+       16-bit value */
+    for ( scan = offset; scan < index->numfields; ++scan )
+    {
+        if ( ! ( index->fields [ scan ].flags & FUDGE_FIELD_HAS_ORDINAL ) )
+            continue;
+        ordinal = ( unsigned short ) index->fields [ scan ].ordinal;
+        if ( ordinal >= index->ordinalspan )
+            index->ordinalspan = ordinal + 1;
+    }
+
+    limit = ( size_t ) index->numfields * FIELDINDEX_ORDINAL_SPREAD;
+    if ( limit < FIELDINDEX_MIN_ORDINALS )
+        limit = FIELDINDEX_MIN_ORDINALS;
+    if ( index->ordinalspan > limit )
+    {
+        free ( index->ordinals );
+        index->ordinals = 0;
+        index->numordinals = 0;
+        return 0;
+    }
+
+    if ( ! index->ordinals || index->ordinalspan > index->numordinals )
+    {
+        capacity = index->numordinals * 2;
+        if ( capacity < index->ordinalspan )
+            capacity = index->ordinalspan;
+        if ( capacity > limit )
+            capacity = limit;
+
+        free ( index->ordinals );
+        if ( ! ( index->ordinals = ( fudge_i32 * ) calloc ( capacity + 1,
+                                                            sizeof ( fudge_i32 ) ) ) )
+        {
+            index->numordinals = 0;
+            return -1;
+        }
+        index->numordinals = capacity;
+        offset = 0;
+    }
+
+    for ( ; offset < index->numfields; ++offset )
+    {
+        if ( ! ( index->fields [ offset ].flags & FUDGE_FIELD_HAS_ORDINAL ) )
+            continue;
+        ordinal = ( unsigned short ) index->fields [ offset ].ordinal;
+        if ( ! index->ordinals [ ordinal ] )
+            index->ordinals [ ordinal ] = offset + 1;
+    }
+    return 0;
+}
+
+FieldIndex * fieldindex_create ( FudgeMsg message )
+{
+    FieldIndex * index;
+
+    if ( ! ( index = ( FieldIndex * ) calloc ( 1, sizeof ( FieldIndex ) ) ) )
+        return 0;
+    if ( fieldindex_update ( index, message ) )
+    {
+        fieldindex_destroy ( index );
+        return 0;
+    }
+    return index;
+}
+
+int fieldindex_update ( FieldIndex * index, FudgeMsg message )
+{
+    fudge_i32 offset = index->numfields,
+              numfields = ( fudge_i32 ) FudgeMsg_numFields ( message ),
+              capacity;
+    FudgeField * fields;
+
+    /* Fudge-C can only copy out a prefix of the fields, so the snapshot is
+       refreshed in full; existing entries are unchanged by this, as fields
+       can only be appended */
+    if ( numfields + 1 > index->fieldcapacity )
+    {
+        capacity = index->fieldcapacity ? index->fieldcapacity : 8;
+        while ( capacity < numfields + 1 )
+            capacity *= 2;
+        if ( ! ( fields = ( FudgeField * ) realloc ( index->fields,
+                                                     sizeof ( FudgeField ) * capacity ) ) )
+            return -1;
+        index->fields = fields;
+        index->fieldcapacity = capacity;
+    }
+    index->numfields = FudgeMsg_getFields ( index->fields, numfields, message );
+
+    if ( fieldindex_addNames ( index, offset ) || fieldindex_addOrdinals ( index, offset ) )
+        return -1;
+    return 0;
+}
+
+void fieldindex_destroy ( FieldIndex * index )
+{
+    if ( index )
+    {
+        free ( index->fields );
+        free ( index->names );
+        free ( index->ordinals );
+        free ( index );
+    }
+}
+
+int fieldindex_isStale ( const FieldIndex * index, FudgeMsg message )
+{
+    /* Fields can only be added to a message, never removed */
+    return ( size_t ) index->numfields != FudgeMsg_numFields ( message );
+}
+
+const FudgeField * fieldindex_findName ( const FieldIndex * index,
+                                         FudgeString name )
+{
+    fudge_i32 slot = *fieldindex_findNameSlot ( index, name );
+    return slot ? index->fields + slot - 1 : 0;
+}
+
+const FudgeField * fieldindex_findOrdinal ( const FieldIndex * index,
+                                            fudge_i16 ordinal )
+{
+    size_t offset = ( unsigned short ) ordinal;
+
+    if ( offset >= index->numordinals || ! index->ordinals [ offset ] )
+        return 0;
+    return index->fields + index->ordinals [ offset ] - 1;
+}
+
+int fieldindex_hasOrdinals ( const FieldIndex * index )
+{
+    return index->ordinals != 0;
+}
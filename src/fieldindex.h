@@ -0,0 +1,62 @@
+/**
+ * Copyright (C) 2012 - 2012, Vrai Stacey.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef INC_FUDGEPYC_FIELDINDEX_H
+#define INC_FUDGEPYC_FIELDINDEX_H
+
+#include <fudge/message.h>
+
+/* Lookup index over a snapshot of a message's fields: a hash table of the
+ * field names and a dense table of the field ordinals. As with Fudge-C's
+ * own lookups, only the first field with a given name or ordinal is found.
+ * These functions never touch Python objects. */
+
+typedef struct
+{
+    FudgeField * fields;        /* Snapshot of the message's fields */
+    fudge_i32 numfields;
+    fudge_i32 fieldcapacity;
+    fudge_i32 * names;          /* Field index + 1, or 0 for an empty slot */
+    size_t namecapacity;        /* Always a power of two */
+    fudge_i32 * ordinals;       /* Field index + 1 by ordinal, 0 if absent */
+    size_t numordinals;         /* Zero if the ordinals were too sparse */
+    size_t ordinalspan;         /* Highest ordinal in the message, plus one */
+} FieldIndex;
+
+/* Returns a new index of the message's fields, or null if memory could not
+ * be allocated */
+extern FieldIndex * fieldindex_create ( FudgeMsg message );
+
+extern void fieldindex_destroy ( FieldIndex * index );
+
+/* Brings a stale index up to date by adding the fields appended to the
+ * message since. Returns 0 on success, or -1 if memory could not be
+ * allocated, in which case the index must be destroyed. */
+extern int fieldindex_update ( FieldIndex * index, FudgeMsg message );
+
+/* True if the message has had fields added since the index was created */
+extern int fieldindex_isStale ( const FieldIndex * index, FudgeMsg message );
+
+/* Return the first field with the name/ordinal, or null if there is none */
+extern const FudgeField * fieldindex_findName ( const FieldIndex * index,
+                                                FudgeString name );
+extern const FudgeField * fieldindex_findOrdinal ( const FieldIndex * index,
+                                                   fudge_i16 ordinal );
+
+/* False if the ordinals were too sparse for a dense table, in which case
+ * fieldindex_findOrdinal must not be used */
+extern int fieldindex_hasOrdinals ( const FieldIndex * index );
+
+#endif
@@ -15,9 +15,13 @@
  */
 #include <Python.h>
 #include "converters.h"
+#include "dictcodec.h"
 #include "envelope.h"
 #include "field.h"
+#include "messagetemplate.h"
 #include "modulemethods.h"
+#include "streamdecoder.h"
+#include "timezone.h"
 #include "version.h"
 
 typedef struct
@@ -29,15 +33,22 @@ typedef struct
 
 static ModuleTypeDef module_types [] =
 {
-    { "Envelope", &EnvelopeType, NULL },
-    { "Field",    &FieldType,    Field_modinit },
-    { "Message",  &MessageType,  Message_modinit },
+    { "Envelope",        &EnvelopeType,        NULL },
+    { "Field",           &FieldType,           Field_modinit },
+    { "Message",         &MessageType,         Message_modinit },
+    { "MessageTemplate", &MessageTemplateType, NULL },
+    { "StreamDecoder",   &StreamDecoderType,   NULL },
     { NULL }
 };
 
 static PyMethodDef module_methods [] =
 {
-    { "init", ( PyCFunction ) fudgepyc_init, METH_NOARGS, DOC_fudgepyc_init },
+    { "init",           ( PyCFunction ) fudgepyc_init,           METH_NOARGS,                  DOC_fudgepyc_init },
+    { "decodeParallel", ( PyCFunction ) fudgepyc_decodeParallel, METH_VARARGS | METH_KEYWORDS, DOC_fudgepyc_decodeParallel },
+    { "nameCacheStats", ( PyCFunction ) fudgepyc_nameCacheStats, METH_NOARGS,                  DOC_fudgepyc_nameCacheStats },
+    { "clearNameCache", ( PyCFunction ) fudgepyc_clearNameCache, METH_NOARGS,                  DOC_fudgepyc_clearNameCache },
+    { "loads",          ( PyCFunction ) fudgepyc_loads,          METH_VARARGS | METH_KEYWORDS, DOC_fudgepyc_loads },
+    { "dumps",          ( PyCFunction ) fudgepyc_dumps,          METH_VARARGS | METH_KEYWORDS, DOC_fudgepyc_dumps },
     { NULL }
 };
 
@@ -115,6 +126,11 @@ PyMODINIT_FUNC initimpl ( void )
     if ( fudgepyc_initialiseConverters ( module ) )
         return;
 
+    /* Timezone derives from datetime.tzinfo, so readies itself rather than
+       being listed in module_types */
+    if ( Timezone_modinit ( module ) )
+        return;
+
     PyModule_AddStringConstant ( module, "__version__", fudgepyc_version );
 
     for ( mtdef = module_types; mtdef->name; ++mtdef )
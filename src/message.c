@@ -14,10 +14,16 @@
  * limitations under the License.
  */
 #include "message.h"
+#include "content.h"
 #include "converters.h"
 #include "field.h"
+#include "namecache.h"
+#include "wire.h"
 #include <datetime.h>
 
+/* Reference to the array.array type, used for typed getAllValues results */
+static PyObject * s_arraytype = 0;
+
 /****************************************************************************
  * Constructor/destructor implementations
  */
@@ -29,7 +35,10 @@ static const char DOC_fudgepyc_message [] =
     "themselves contain no meta-data.\n\n"
     "Field order is maintained across encoding and decoding, fields will\n"
     "remain in insertion order; regardless of if they have a name and/or\n"
-    "ordinal.\n"
+    "ordinal.\n\n"
+    "Messages compare equal if their fields have the same names, ordinals,\n"
+    "types and values, in the same order. Only frozen messages are hashable;\n"
+    "see Message.freeze.\n"
     "\n"
     "@return: Message instance\n";
 static int Message_init ( Message * self, PyObject * args, PyObject * kwds )
@@ -49,6 +58,13 @@ static PyObject * Message_new ( PyTypeObject * type, PyObject * args, PyObject *
     {
         obj->msg = 0;
         obj->msgdict = 0;
+        obj->index = 0;
+        obj->stalelookups = 0;
+        obj->frozen = 0;
+        obj->hashed = 0;
+        obj->contenthash = 0;
+        obj->epochnanos = 0;
+        obj->asciistr = 0;
     }
     return ( PyObject * ) obj;
 }
@@ -57,6 +73,7 @@ static void Message_dealloc ( Message * self )
 {
     FudgeMsg_release ( self->msg );
     Py_XDECREF( self->msgdict );
+    fieldindex_destroy ( self->index );
     self->ob_type->tp_free ( self );
 }
 
@@ -66,129 +83,85 @@ static void Message_dealloc ( Message * self )
  */
 
 #define MESSAGE_ADD_FIELD_SCALAR_IMPL( TYPENAME, CTYPE, CLEANUP )           \
-static PyObject * Message_addField ## TYPENAME ## Impl (                    \
+static int Message_addField ## TYPENAME ## Raw (                            \
            Message * self,                                                  \
            PyObject * valobj,                                               \
-           PyObject * nameobj,                                              \
-           PyObject * ordobj )                                              \
+           FudgeString name,                                                \
+           const fudge_i16 * ordinal )                                      \
 {                                                                           \
     FudgeStatus status;                                                     \
-    FudgeString name = 0;                                                   \
-    fudge_i16 ordinal;                                                      \
     CTYPE value;                                                            \
                                                                             \
     if ( fudgepyc_convertPythonTo ## TYPENAME ( &value, valobj ) )          \
-        return 0;                                                           \
-    if ( ordobj && Message_parseOrdinalObject ( &ordinal, ordobj ) )        \
-        return 0;                                                           \
-    if ( nameobj && Message_parseNameObject ( &name, nameobj ) )            \
-        return 0;                                                           \
+        return -1;                                                          \
                                                                             \
     status = FudgeMsg_addField ## TYPENAME ( self->msg,                     \
                                              name,                          \
-                                             ordobj ? &ordinal : 0,         \
+                                             ordinal,                       \
                                              value );                       \
-    FudgeString_release ( name );                                           \
     CLEANUP                                                                 \
-                                                                            \
-    if ( exception_raiseOnError ( status ) )                                \
-        return 0;                                                           \
-    Py_RETURN_NONE;                                                         \
+    return exception_raiseOnError ( status );                               \
 }
 
 #define MESSAGE_ADD_FIELD_PTR_IMPL( TYPENAME, CTYPE )                       \
-static PyObject * Message_addField ## TYPENAME ## Impl (                    \
+static int Message_addField ## TYPENAME ## Raw (                            \
            Message * self,                                                  \
            PyObject * valobj,                                               \
-           PyObject * nameobj,                                              \
-           PyObject * ordobj )                                              \
+           FudgeString name,                                                \
+           const fudge_i16 * ordinal )                                      \
 {                                                                           \
-    FudgeStatus status;                                                     \
-    FudgeString name = 0;                                                   \
-    fudge_i16 ordinal;                                                      \
     CTYPE value;                                                            \
                                                                             \
     memset ( &value, 0, sizeof ( value ) );                                 \
                                                                             \
     if ( fudgepyc_convertPythonTo ## TYPENAME ( &value, valobj ) )          \
-        return 0;                                                           \
-    if ( ordobj && Message_parseOrdinalObject ( &ordinal, ordobj ) )        \
-        return 0;                                                           \
-    if ( nameobj && Message_parseNameObject ( &name, nameobj ) )            \
-        return 0;                                                           \
-                                                                            \
-    status = FudgeMsg_addField ## TYPENAME ( self->msg,                     \
-                                             name,                          \
-                                             ordobj ? &ordinal : 0,         \
-                                             &value );                      \
-    FudgeString_release ( name );                                           \
+        return -1;                                                          \
                                                                             \
-    if ( exception_raiseOnError ( status ) )                                \
-        return 0;                                                           \
-    Py_RETURN_NONE;                                                         \
+    return exception_raiseOnError (                                         \
+               FudgeMsg_addField ## TYPENAME ( self->msg,                   \
+                                               name,                        \
+                                               ordinal,                     \
+                                               &value ) );                  \
 }
 
 #define MESSAGE_ADD_FIELD_ARRAY_IMPL( TYPENAME, CTYPE )                     \
-static PyObject * Message_addField ## TYPENAME ## ArrayImpl (               \
+static int Message_addField ## TYPENAME ## ArrayRaw (                       \
            Message * self,                                                  \
            PyObject * valobj,                                               \
-           PyObject * nameobj,                                              \
-           PyObject * ordobj )                                              \
+           FudgeString name,                                                \
+           const fudge_i16 * ordinal )                                      \
 {                                                                           \
     FudgeStatus status;                                                     \
-    FudgeString name = 0;                                                   \
-    fudge_i16 ordinal;                                                      \
-    CTYPE * array;                                                          \
-    fudge_i32 size;                                                         \
-                                                                            \
-    if ( fudgepyc_convertPythonTo ## TYPENAME ## Array ( &array,            \
-                                                         &size,             \
-                                                         valobj ) )         \
-        return 0;                                                           \
-    if ( ordobj && Message_parseOrdinalObject ( &ordinal, ordobj ) )        \
-        return 0;                                                           \
-    if ( nameobj && Message_parseNameObject ( &name, nameobj ) )            \
-        return 0;                                                           \
+    ConverterArray array;                                                   \
                                                                             \
-    status = FudgeMsg_addField ## TYPENAME ## Array ( self->msg,            \
-                                                      name,                 \
-                                                      ordobj ? &ordinal : 0,\
-                                                      array,                \
-                                                      size );               \
-    PyMem_Free ( array );                                                   \
-    FudgeString_release ( name );                                           \
+    if ( fudgepyc_getPython ## TYPENAME ## Array ( &array, valobj ) )       \
+        return -1;                                                          \
                                                                             \
-    if ( exception_raiseOnError ( status ) )                                \
-        return 0;                                                           \
-    Py_RETURN_NONE;                                                         \
+    status = FudgeMsg_addField ## TYPENAME ## Array (                       \
+                 self->msg,                                                 \
+                 name,                                                      \
+                 ordinal,                                                   \
+                 ( const CTYPE * ) array.data,                              \
+                 array.size );                                              \
+    fudgepyc_releaseArray ( &array );                                       \
+    return exception_raiseOnError ( status );                               \
 }
 
 #define MESSAGE_ADD_FIELD_FIXED_ARRAY_IMPL( WIDTH )                         \
-static PyObject * Message_addField ## WIDTH ## ByteArrayImpl (              \
+static int Message_addField ## WIDTH ## ByteArrayRaw (                      \
            Message * self,                                                  \
            PyObject * valobj,                                               \
-           PyObject * nameobj,                                              \
-           PyObject * ordobj )                                              \
+           FudgeString name,                                                \
+           const fudge_i16 * ordinal )                                      \
 {                                                                           \
-    FudgeStatus status;                                                     \
-    FudgeString name = 0;                                                   \
-    fudge_i16 ordinal;                                                      \
     fudge_byte array [ WIDTH ];                                             \
                                                                             \
     if ( fudgepyc_convertPythonToFixedByteArray ( array, WIDTH, valobj ) )  \
-        return 0;                                                           \
-    if ( ordobj && Message_parseOrdinalObject ( &ordinal, ordobj ) )        \
-        return 0;                                                           \
-    if ( nameobj && Message_parseNameObject ( &name, nameobj ) )            \
-        return 0;                                                           \
-                                                                            \
-    status = FudgeMsg_addField ## WIDTH ## ByteArray (                      \
-                 self->msg, name, ordobj ? &ordinal : 0, array );           \
-    FudgeString_release ( name );                                           \
+        return -1;                                                          \
                                                                             \
-    if ( exception_raiseOnError ( status ) )                                \
-        return 0;                                                           \
-    Py_RETURN_NONE;                                                         \
+    return exception_raiseOnError (                                         \
+               FudgeMsg_addField ## WIDTH ## ByteArray (                    \
+                   self->msg, name, ordinal, array ) );                     \
 }
 
 #define MESSAGE_ADD_FIELD_SCALAR( TYPENAME, PYSTR, FUDGESTR )               \
@@ -213,8 +186,9 @@ PyObject * Message_addField ## TYPENAME ( Message * self,                   \
                                          &PyInt_Type, &ordobj ) )           \
         return 0;                                                           \
                                                                             \
-    return Message_addField ## TYPENAME ## Impl (                           \
-               self, valobj, nameobj, ordobj );                             \
+    return Message_addFieldWithAdder ( self,                                \
+                                       Message_addField ## TYPENAME ## Raw, \
+                                       valobj, nameobj, ordobj );           \
 }
 
 #define MESSAGE_ADD_FIELD_ARRAY( TYPENAME, PYSTR, FUDGESTR )                \
@@ -239,8 +213,10 @@ PyObject * Message_addField ## TYPENAME ## Array ( Message * self,          \
                                          &PyInt_Type, &ordobj ) )           \
         return 0;                                                           \
                                                                             \
-    return Message_addField ## TYPENAME ## ArrayImpl (                      \
-               self, valobj, nameobj, ordobj );                             \
+    return Message_addFieldWithAdder (                                      \
+               self,                                                        \
+               Message_addField ## TYPENAME ## ArrayRaw,                    \
+               valobj, nameobj, ordobj );                                   \
 }
 
 #define MESSAGE_ADD_FIELD_FIXED_ARRAY( WIDTH )                              \
@@ -267,21 +243,176 @@ PyObject * Message_addField ## WIDTH ## ByteArray (                         \
                                          &PyInt_Type, &ordobj ) )           \
         return 0;                                                           \
                                                                             \
-    return Message_addField ## WIDTH ## ByteArrayImpl (                     \
-               self, valobj, nameobj, ordobj );                             \
+    return Message_addFieldWithAdder (                                      \
+               self,                                                        \
+               Message_addField ## WIDTH ## ByteArrayRaw,                   \
+               valobj, nameobj, ordobj );                                   \
+}
+
+
+/****************************************************************************
+ * Iterator implementation
+ */
+
+/* Iterates over a snapshot of a Message's fields, taken when the iterator
+ * is created; Field objects (or values) are only created as each field is
+ * reached */
+typedef struct
+{
+    PyObject_HEAD
+    Message * message;
+    FudgeField * fields;
+    Py_ssize_t numfields;
+    Py_ssize_t index;
+    int values;             /* Yield field values rather than Fields */
+} MessageIterator;
+
+static PyTypeObject MessageIteratorType;
+
+static const char DOC_fudgepyc_messageiterator [] =
+    "\nIterator over the fields, or field values, of a fudgepyc.Message\n";
+
+static PyObject * Message_createIterator ( Message * self, int values )
+{
+    MessageIterator * iterator;
+
+    if ( ! ( iterator = PyObject_New ( MessageIterator, &MessageIteratorType ) ) )
+        return 0;
+
+    Py_INCREF( ( PyObject * ) self );
+    iterator->message = self;
+    iterator->fields = 0;
+    iterator->numfields = ( Py_ssize_t ) FudgeMsg_numFields ( self->msg );
+    iterator->index = 0;
+    iterator->values = values;
+
+    if ( iterator->numfields )
+    {
+        if ( ! ( iterator->fields = PyMem_New ( FudgeField, iterator->numfields ) ) )
+        {
+            Py_DECREF( iterator );
+            return PyErr_NoMemory ( );
+        }
+        iterator->numfields = FudgeMsg_getFields ( iterator->fields,
+                                                   ( fudge_i32 ) iterator->numfields,
+                                                   self->msg );
+    }
+    return ( PyObject * ) iterator;
+}
+
+static void MessageIterator_dealloc ( MessageIterator * self )
+{
+    Py_XDECREF( self->message );
+    PyMem_Free ( self->fields );
+    PyObject_Del ( self );
+}
+
+static PyObject * MessageIterator_iternext ( MessageIterator * self )
+{
+    const FudgeField * field;
+
+    if ( self->index >= self->numfields )
+        return 0;
+
+    field = self->fields + self->index++;
+    if ( self->values )
+        return Field_convertMessageValue ( field, self->message );
+    return Field_create ( *field, self->message );
 }
 
+static PyTypeObject MessageIteratorType =
+{
+    PyObject_HEAD_INIT( NULL )
+    0,                                              /* ob_size */
+    "fudgepyc.MessageIterator",                     /* tp_name */
+    sizeof ( MessageIterator ),                     /* tp_basicsize */
+    0,                                              /* tp_itemsize */
+    ( destructor ) MessageIterator_dealloc,         /* tp_dealloc */
+    0,                                              /* tp_print */
+    0,                                              /* tp_getattr */
+    0,                                              /* tp_setattr */
+    0,                                              /* tp_compare */
+    0,                                              /* tp_repr */
+    0,                                              /* tp_as_number */
+    0,                                              /* tp_as_sequence */
+    0,                                              /* tp_as_mapping */
+    0,                                              /* tp_hash */
+    0,                                              /* tp_call */
+    0,                                              /* tp_str */
+    0,                                              /* tp_getattro */
+    0,                                              /* tp_setattro */
+    0,                                              /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT,                             /* tp_flags */
+    DOC_fudgepyc_messageiterator,                   /* tp_doc */
+    0,                                              /* tp_traverse */
+    0,                                              /* tp_clear */
+    0,                                              /* tp_richcompare */
+    0,                                              /* tp_weaklistoffset */
+    PyObject_SelfIter,                              /* tp_iter */
+    ( iternextfunc ) MessageIterator_iternext,      /* tp_iternext */
+};
+
 
 /****************************************************************************
  * Internal functions
  */
 
+/* Messages with fewer fields than this are searched linearly, as building
+ * an index would cost more than it saves */
+#define MESSAGE_INDEX_MIN_FIELDS 8
+
+/* Once fields have been added, lookups search linearly this many times
+ * before the index is brought up to date. Updating costs about as much as
+ * one linear search, so interleaved adds and lookups (as when building a
+ * message) are never much slower than they would be without an index. */
+#define MESSAGE_INDEX_STALE_LOOKUPS 8
+
+/* Sets index to the Message's lookup index, building it on first use and
+ * updating it if fields have since been added. The index is null if the
+ * Message is too small to be worth indexing, or if it is stale and the
+ * lookup should search linearly. Returns 0 on success or -1 with an
+ * exception set. */
+static int Message_getIndex ( Message * self, FieldIndex * * index )
+{
+    if ( self->index && fieldindex_isStale ( self->index, self->msg ) )
+    {
+        if ( self->stalelookups < MESSAGE_INDEX_STALE_LOOKUPS )
+        {
+            ++self->stalelookups;
+            *index = 0;
+            return 0;
+        }
+
+        self->stalelookups = 0;
+        if ( fieldindex_update ( self->index, self->msg ) )
+        {
+            fieldindex_destroy ( self->index );
+            self->index = 0;
+            PyErr_NoMemory ( );
+            return -1;
+        }
+    }
+
+    if ( ! self->index &&
+         FudgeMsg_numFields ( self->msg ) >= MESSAGE_INDEX_MIN_FIELDS &&
+         ! ( self->index = fieldindex_create ( self->msg ) ) )
+    {
+        PyErr_NoMemory ( );
+        return -1;
+    }
+
+    *index = self->index;
+    return 0;
+}
+
 static PyObject * Message_getFieldWithName ( Message * self,
                                              FudgeString name,
                                              int exception )
 {
     FudgeField field;
     FudgeStatus status;
+    FieldIndex * index;
+    const FudgeField * indexed;
     size_t namelen;
 
     if ( ( namelen = FudgeString_getLength ( name ) ) > 256 )
@@ -290,7 +421,17 @@ static PyObject * Message_getFieldWithName ( Message * self,
         return 0;
     }
 
-    status = FudgeMsg_getFieldByName ( &field, self->msg, name );
+    if ( Message_getIndex ( self, &index ) )
+        return 0;
+    if ( index )
+    {
+        if ( ( indexed = fieldindex_findName ( index, name ) ) )
+            return Field_create ( *indexed, self );
+        status = FUDGE_INVALID_NAME;
+    }
+    else
+        status = FudgeMsg_getFieldByName ( &field, self->msg, name );
+
     switch ( status )
     {
         case FUDGE_OK:
@@ -325,8 +466,20 @@ static PyObject * Message_getFieldWithOrdinal ( Message * self,
 {
     FudgeField field;
     FudgeStatus status;
+    FieldIndex * index;
+    const FudgeField * indexed;
+
+    if ( Message_getIndex ( self, &index ) )
+        return 0;
+    if ( index && fieldindex_hasOrdinals ( index ) )
+    {
+        if ( ( indexed = fieldindex_findOrdinal ( index, ordinal ) ) )
+            return Field_create ( *indexed, self );
+        status = FUDGE_INVALID_ORDINAL;
+    }
+    else
+        status = FudgeMsg_getFieldByOrdinal ( &field, self->msg, ordinal );
 
-    status = FudgeMsg_getFieldByOrdinal ( &field, self->msg, ordinal );
     switch ( status )
     {
         case FUDGE_OK:
@@ -348,7 +501,217 @@ static PyObject * Message_getFieldWithOrdinal ( Message * self,
     }
 }
 
-static int Message_parseOrdinalObject ( fudge_i16 * target, PyObject * source )
+#define MESSAGE_COPY_ARRAY( TYPENAME, CTYPE )                               \
+    FudgeMsg_addField ## TYPENAME ## Array (                                \
+        target,                                                             \
+        name,                                                               \
+        ordinal,                                                            \
+        ( const CTYPE * ) field->data.bytes,                                \
+        ( fudge_i32 ) ( field->numbytes / sizeof ( CTYPE ) ) )
+
+#define MESSAGE_COPY_FIXED_ARRAY( WIDTH )                                   \
+    FudgeMsg_addField ## WIDTH ## ByteArray ( target,                       \
+                                              name,                         \
+                                              ordinal,                      \
+                                              field->data.bytes )
+
+/* Maps each sub-message met during a deep copy to its copy, so that a
+ * sub-message held more than once is only copied once and stays shared */
+typedef struct
+{
+    FudgeMsg * entries;     /* Source/copy pairs; a null source is empty */
+    size_t capacity;        /* Number of pairs, always a power of two */
+    size_t count;
+} MessageCopyMemo;
+
+static FudgeMsg * Message_findCopySlot ( const MessageCopyMemo * memo,
+                                         FudgeMsg source )
+{
+    size_t mask = memo->capacity - 1,
+           slot = ( ( ( size_t ) source >> 4 ) * 2654435761u ) & mask;
+
+    while ( memo->entries [ slot * 2 ] && memo->entries [ slot * 2 ] != source )
+        slot = ( slot + 1 ) & mask;
+    return memo->entries + slot * 2;
+}
+
+/* Records the copy of source; the memo keeps the table no more than half
+ * full. The copy is not retained, its new parent message keeps it alive. */
+static FudgeStatus Message_addCopy ( MessageCopyMemo * memo,
+                                     FudgeMsg source,
+                                     FudgeMsg copy )
+{
+    FudgeMsg * entries = memo->entries, * slot;
+    size_t capacity = memo->capacity, index;
+
+    if ( ( memo->count + 1 ) * 2 > capacity )
+    {
+        memo->capacity = capacity ? capacity * 2 : 16;
+        if ( ! ( memo->entries = ( FudgeMsg * ) calloc ( memo->capacity * 2,
+                                                         sizeof ( FudgeMsg ) ) ) )
+        {
+            memo->entries = entries;
+            memo->capacity = capacity;
+            return FUDGE_OUT_OF_MEMORY;
+        }
+
+        for ( index = 0; index < capacity; ++index )
+        {
+            if ( ! entries [ index * 2 ] )
+                continue;
+            slot = Message_findCopySlot ( memo, entries [ index * 2 ] );
+            slot [ 0 ] = entries [ index * 2 ];
+            slot [ 1 ] = entries [ index * 2 + 1 ];
+        }
+        free ( entries );
+    }
+
+    slot = Message_findCopySlot ( memo, source );
+    slot [ 0 ] = source;
+    slot [ 1 ] = copy;
+    ++memo->count;
+    return FUDGE_OK;
+}
+
+static FudgeStatus Message_copyFields ( FudgeMsg target,
+                                        FudgeMsg source,
+                                        MessageCopyMemo * memo );
+
+/* Adds a copy of field to target. Strings and names are immutable and so
+ * are shared rather than copied, as are sub-messages unless memo is set
+ * (for a deep copy). */
+static FudgeStatus Message_copyField ( FudgeMsg target,
+                                       const FudgeField * field,
+                                       MessageCopyMemo * memo )
+{
+    FudgeString name = field->flags & FUDGE_FIELD_HAS_NAME ? field->name : 0;
+    const fudge_i16 * ordinal = field->flags & FUDGE_FIELD_HAS_ORDINAL ? &field->ordinal : 0;
+    FudgeStatus status;
+    FudgeMsg submsg, * slot;
+    fudge_byte * bytes;
+
+    switch ( field->type )
+    {
+        case FUDGE_TYPE_INDICATOR:
+            return FudgeMsg_addFieldIndicator ( target, name, ordinal );
+        case FUDGE_TYPE_BOOLEAN:
+            return FudgeMsg_addFieldBool ( target, name, ordinal, field->data.boolean );
+        case FUDGE_TYPE_BYTE:
+            return FudgeMsg_addFieldByte ( target, name, ordinal, field->data.byte );
+        case FUDGE_TYPE_SHORT:
+            return FudgeMsg_addFieldI16 ( target, name, ordinal, field->data.i16 );
+        case FUDGE_TYPE_INT:
+            return FudgeMsg_addFieldI32 ( target, name, ordinal, field->data.i32 );
+        case FUDGE_TYPE_LONG:
+            return FudgeMsg_addFieldI64 ( target, name, ordinal, field->data.i64 );
+        case FUDGE_TYPE_FLOAT:
+            return FudgeMsg_addFieldF32 ( target, name, ordinal, field->data.f32 );
+        case FUDGE_TYPE_DOUBLE:
+            return FudgeMsg_addFieldF64 ( target, name, ordinal, field->data.f64 );
+
+        case FUDGE_TYPE_BYTE_ARRAY:     return MESSAGE_COPY_ARRAY( Byte, fudge_byte );
+        case FUDGE_TYPE_SHORT_ARRAY:    return MESSAGE_COPY_ARRAY( I16,  fudge_i16 );
+        case FUDGE_TYPE_INT_ARRAY:      return MESSAGE_COPY_ARRAY( I32,  fudge_i32 );
+        case FUDGE_TYPE_LONG_ARRAY:     return MESSAGE_COPY_ARRAY( I64,  fudge_i64 );
+        case FUDGE_TYPE_FLOAT_ARRAY:    return MESSAGE_COPY_ARRAY( F32,  fudge_f32 );
+        case FUDGE_TYPE_DOUBLE_ARRAY:   return MESSAGE_COPY_ARRAY( F64,  fudge_f64 );
+
+        case FUDGE_TYPE_BYTE_ARRAY_4:   return MESSAGE_COPY_FIXED_ARRAY( 4 );
+        case FUDGE_TYPE_BYTE_ARRAY_8:   return MESSAGE_COPY_FIXED_ARRAY( 8 );
+        case FUDGE_TYPE_BYTE_ARRAY_16:  return MESSAGE_COPY_FIXED_ARRAY( 16 );
+        case FUDGE_TYPE_BYTE_ARRAY_20:  return MESSAGE_COPY_FIXED_ARRAY( 20 );
+        case FUDGE_TYPE_BYTE_ARRAY_32:  return MESSAGE_COPY_FIXED_ARRAY( 32 );
+        case FUDGE_TYPE_BYTE_ARRAY_64:  return MESSAGE_COPY_FIXED_ARRAY( 64 );
+        case FUDGE_TYPE_BYTE_ARRAY_128: return MESSAGE_COPY_FIXED_ARRAY( 128 );
+        case FUDGE_TYPE_BYTE_ARRAY_256: return MESSAGE_COPY_FIXED_ARRAY( 256 );
+        case FUDGE_TYPE_BYTE_ARRAY_512: return MESSAGE_COPY_FIXED_ARRAY( 512 );
+
+        case FUDGE_TYPE_STRING:
+            return FudgeMsg_addFieldString ( target, name, ordinal, field->data.string );
+
+        case FUDGE_TYPE_FUDGE_MSG:
+            if ( ! memo )
+                return FudgeMsg_addFieldMsg ( target, name, ordinal, field->data.message );
+            if ( *( slot = Message_findCopySlot ( memo, field->data.message ) ) )
+                return FudgeMsg_addFieldMsg ( target, name, ordinal, slot [ 1 ] );
+
+            /* Record the copy before filling it, in case it holds itself */
+            if ( ( status = FudgeMsg_create ( &submsg ) ) != FUDGE_OK )
+                return status;
+            if ( ( status = Message_addCopy ( memo, field->data.message, submsg ) ) == FUDGE_OK &&
+                 ( status = Message_copyFields ( submsg, field->data.message, memo ) ) == FUDGE_OK )
+                status = FudgeMsg_addFieldMsg ( target, name, ordinal, submsg );
+            FudgeMsg_release ( submsg );
+            return status;
+
+        case FUDGE_TYPE_DATE:
+            return FudgeMsg_addFieldDate ( target, name, ordinal, &field->data.datetime.date );
+        case FUDGE_TYPE_TIME:
+            return FudgeMsg_addFieldTime ( target, name, ordinal, &field->data.datetime.time );
+        case FUDGE_TYPE_DATETIME:
+            return FudgeMsg_addFieldDateTime ( target, name, ordinal, &field->data.datetime );
+
+        /* Unknown types; the message takes ownership of the payload copy */
+        default:
+            if ( ! ( bytes = ( fudge_byte * ) malloc ( field->numbytes ? field->numbytes : 1 ) ) )
+                return FUDGE_OUT_OF_MEMORY;
+            memcpy ( bytes, field->data.bytes, field->numbytes );
+            if ( ( status = FudgeMsg_addFieldOpaque ( target,
+                                                      field->type,
+                                                      name,
+                                                      ordinal,
+                                                      bytes,
+                                                      field->numbytes ) ) != FUDGE_OK )
+                free ( bytes );
+            return status;
+    }
+}
+
+static FudgeStatus Message_copyFields ( FudgeMsg target,
+                                        FudgeMsg source,
+                                        MessageCopyMemo * memo )
+{
+    FudgeField * fields = 0;
+    FudgeStatus status = FUDGE_OK;
+    fudge_i32 numfields, index;
+
+    if ( ( numfields = ( fudge_i32 ) FudgeMsg_numFields ( source ) ) )
+    {
+        if ( ! ( fields = ( FudgeField * ) malloc ( sizeof ( FudgeField ) * numfields ) ) )
+            return FUDGE_OUT_OF_MEMORY;
+        numfields = FudgeMsg_getFields ( fields, numfields, source );
+    }
+
+    for ( index = 0; index < numfields && status == FUDGE_OK; ++index )
+        status = Message_copyField ( target, fields + index, memo );
+
+    free ( fields );
+    return status;
+}
+
+FudgeStatus Message_copyMsg ( FudgeMsg * target, FudgeMsg source, int deep )
+{
+    MessageCopyMemo memo = { 0, 0, 0 };
+    FudgeStatus status;
+
+    if ( ( status = FudgeMsg_create ( target ) ) != FUDGE_OK )
+        return status;
+
+    if ( deep )
+        status = Message_addCopy ( &memo, source, *target );
+    if ( status == FUDGE_OK )
+        status = Message_copyFields ( *target, source, deep ? &memo : 0 );
+
+    free ( memo.entries );
+    if ( status == FUDGE_OK )
+        return status;
+
+    FudgeMsg_release ( *target );
+    *target = 0;
+    return status;
+}
+
+int Message_parseOrdinalObject ( fudge_i16 * target, PyObject * source )
 {
     long temp;
 
@@ -370,7 +733,7 @@ static int Message_parseOrdinalObject ( fudge_i16 * target, PyObject * source )
     return 0;
 }
 
-static int Message_parseNameObject ( FudgeString * target, PyObject * source )
+int Message_parseNameObject ( FudgeString * target, PyObject * source )
 {
     if ( ! ( PyString_Check ( source ) || PyUnicode_Check ( source ) ) )
     {
@@ -378,7 +741,7 @@ static int Message_parseNameObject ( FudgeString * target, PyObject * source )
                               "Only String and Unicode objects may be used as names" );
         return -1;
     }
-    return fudgepyc_convertPythonToString ( target, source );
+    return namecache_getString ( target, source );
 }
 
 static int Message_createMsgDict ( Message * self )
@@ -416,54 +779,32 @@ int Message_getFudgeType ( fudge_type_id * type, PyObject * value )
     return 0;
 }
 
-static PyObject * Message_addFieldIndicatorImpl ( Message * self,
-                                                  PyObject * nameobj,
-                                                  PyObject * ordobj )
+static int Message_addFieldIndicatorRaw ( Message * self,
+                                          PyObject * valobj,
+                                          FudgeString name,
+                                          const fudge_i16 * ordinal )
 {
-    FudgeStatus status;
-    FudgeString name = 0;
-    fudge_i16 ordinal;
-
-    if ( ordobj && Message_parseOrdinalObject ( &ordinal, ordobj ) )
-        return 0;
-    if ( nameobj && Message_parseNameObject ( &name, nameobj ) )
-        return 0;
-
-    status = FudgeMsg_addFieldIndicator ( self->msg, name, ordobj ? &ordinal : 0 );
-    FudgeString_release ( name );
-
-    if ( exception_raiseOnError ( status ) )
-        return 0;
-    Py_RETURN_NONE;
+    return exception_raiseOnError (
+               FudgeMsg_addFieldIndicator ( self->msg, name, ordinal ) );
 }
 
-static PyObject * Message_addFieldMsgImpl ( Message * self,
-                                            PyObject * msgobj,
-                                            PyObject * nameobj,
-                                            PyObject * ordobj )
+static int Message_addFieldMsgRaw ( Message * self,
+                                    PyObject * msgobj,
+                                    FudgeString name,
+                                    const fudge_i16 * ordinal )
 {
-    FudgeStatus status;
-    FudgeString name = 0;
-    fudge_i16 ordinal;
     FudgeMsg message;
 
     if ( fudgepyc_convertPythonToMsg ( &message, msgobj ) )
-        return 0;
-    if ( ordobj && Message_parseOrdinalObject ( &ordinal, ordobj ) )
-        return 0;
-    if ( nameobj && Message_parseNameObject ( &name, nameobj ) )
-        return 0;
-
-    status = FudgeMsg_addFieldMsg ( self->msg,
-                                    name,
-                                    ordobj ? &ordinal : 0,
-                                    message );
-    FudgeString_release ( name );
-    if ( exception_raiseOnError ( status ) )
-        return 0;
+        return -1;
+    if ( exception_raiseOnError ( FudgeMsg_addFieldMsg ( self->msg,
+                                                         name,
+                                                         ordinal,
+                                                         message ) ) )
+        return -1;
 
     Message_storeMessage ( self, ( Message * ) msgobj );
-    Py_RETURN_NONE;
+    return 0;
 }
 
 MESSAGE_ADD_FIELD_SCALAR_IMPL( Bool,   fudge_bool, )
@@ -496,6 +837,81 @@ MESSAGE_ADD_FIELD_FIXED_ARRAY_IMPL( 128 );
 MESSAGE_ADD_FIELD_FIXED_ARRAY_IMPL( 256 );
 MESSAGE_ADD_FIELD_FIXED_ARRAY_IMPL( 512 );
 
+MessageFieldAdder Message_getFieldAdder ( fudge_type_id type )
+{
+    switch ( type )
+    {
+        case FUDGE_TYPE_INDICATOR:      return Message_addFieldIndicatorRaw;
+        case FUDGE_TYPE_BOOLEAN:        return Message_addFieldBoolRaw;
+        case FUDGE_TYPE_BYTE:           return Message_addFieldByteRaw;
+        case FUDGE_TYPE_SHORT:          return Message_addFieldI16Raw;
+        case FUDGE_TYPE_INT:            return Message_addFieldI32Raw;
+        case FUDGE_TYPE_LONG:           return Message_addFieldI64Raw;
+        case FUDGE_TYPE_FLOAT:          return Message_addFieldF32Raw;
+        case FUDGE_TYPE_DOUBLE:         return Message_addFieldF64Raw;
+        case FUDGE_TYPE_STRING:         return Message_addFieldStringRaw;
+        case FUDGE_TYPE_FUDGE_MSG:      return Message_addFieldMsgRaw;
+
+        case FUDGE_TYPE_BYTE_ARRAY:     return Message_addFieldByteArrayRaw;
+        case FUDGE_TYPE_SHORT_ARRAY:    return Message_addFieldI16ArrayRaw;
+        case FUDGE_TYPE_INT_ARRAY:      return Message_addFieldI32ArrayRaw;
+        case FUDGE_TYPE_LONG_ARRAY:     return Message_addFieldI64ArrayRaw;
+        case FUDGE_TYPE_FLOAT_ARRAY:    return Message_addFieldF32ArrayRaw;
+        case FUDGE_TYPE_DOUBLE_ARRAY:   return Message_addFieldF64ArrayRaw;
+
+        case FUDGE_TYPE_BYTE_ARRAY_4:   return Message_addField4ByteArrayRaw;
+        case FUDGE_TYPE_BYTE_ARRAY_8:   return Message_addField8ByteArrayRaw;
+        case FUDGE_TYPE_BYTE_ARRAY_16:  return Message_addField16ByteArrayRaw;
+        case FUDGE_TYPE_BYTE_ARRAY_20:  return Message_addField20ByteArrayRaw;
+        case FUDGE_TYPE_BYTE_ARRAY_32:  return Message_addField32ByteArrayRaw;
+        case FUDGE_TYPE_BYTE_ARRAY_64:  return Message_addField64ByteArrayRaw;
+        case FUDGE_TYPE_BYTE_ARRAY_128: return Message_addField128ByteArrayRaw;
+        case FUDGE_TYPE_BYTE_ARRAY_256: return Message_addField256ByteArrayRaw;
+        case FUDGE_TYPE_BYTE_ARRAY_512: return Message_addField512ByteArrayRaw;
+
+        case FUDGE_TYPE_DATE:           return Message_addFieldDateRaw;
+        case FUDGE_TYPE_TIME:           return Message_addFieldTimeRaw;
+        case FUDGE_TYPE_DATETIME:       return Message_addFieldDateTimeRaw;
+
+        default:                        return 0;
+    }
+}
+
+int Message_checkMutable ( Message * self )
+{
+    if ( ! self->frozen )
+        return 0;
+    exception_raise_any ( PyExc_TypeError, "Cannot add fields to a frozen Message" );
+    return -1;
+}
+
+/* Converts the optional name and ordinal objects before passing them to
+ * the adder */
+static PyObject * Message_addFieldWithAdder ( Message * self,
+                                              MessageFieldAdder adder,
+                                              PyObject * valobj,
+                                              PyObject * nameobj,
+                                              PyObject * ordobj )
+{
+    FudgeString name = 0;
+    fudge_i16 ordinal;
+    int result;
+
+    if ( Message_checkMutable ( self ) )
+        return 0;
+    if ( ordobj && Message_parseOrdinalObject ( &ordinal, ordobj ) )
+        return 0;
+    if ( nameobj && Message_parseNameObject ( &name, nameobj ) )
+        return 0;
+
+    result = adder ( self, valobj, name, ordobj ? &ordinal : 0 );
+    FudgeString_release ( name );
+
+    if ( result )
+        return 0;
+    Py_RETURN_NONE;
+}
+
 
 /****************************************************************************
  * Method implementations
@@ -549,7 +965,11 @@ PyObject * Message_addFieldIndicator ( Message * self, PyObject * args, PyObject
     if ( ! PyArg_ParseTupleAndKeywords ( args, kwds, "|OO!", kwlist, &nameobj, &PyInt_Type, &ordobj ) )
         return 0;
 
-    return Message_addFieldIndicatorImpl ( self, nameobj, ordobj );
+    return Message_addFieldWithAdder ( self,
+                                       Message_addFieldIndicatorRaw,
+                                       Py_None,
+                                       nameobj,
+                                       ordobj );
 }
 
 MESSAGE_ADD_FIELD_SCALAR( Bool,     "bool",              "Boolean" )
@@ -585,7 +1005,11 @@ PyObject * Message_addFieldMsg ( Message * self, PyObject * args, PyObject * kwd
                                          &PyInt_Type, &ordobj ) )
         return 0;
 
-    return Message_addFieldMsgImpl ( self, msgobj, nameobj, ordobj );
+    return Message_addFieldWithAdder ( self,
+                                       Message_addFieldMsgRaw,
+                                       msgobj,
+                                       nameobj,
+                                       ordobj );
 }
 
 MESSAGE_ADD_FIELD_ARRAY( Byte, "String, Unicode or [int, ...]", "Byte[]" )
@@ -636,6 +1060,8 @@ PyObject * Message_addFieldRawDate ( Message * self, PyObject * args, PyObject *
                                                      &PyInt_Type, &ordobj ) )
         return 0;
 
+    if ( Message_checkMutable ( self ) )
+        return 0;
     if ( fudgepyc_convertPythonToDateEx ( &date, yearobj, monthobj, dayobj ) )
         return 0;
     if ( ordobj && Message_parseOrdinalObject ( &ordinal, ordobj ) )
@@ -696,6 +1122,8 @@ PyObject * Message_addFieldRawTime ( Message * self, PyObject * args, PyObject *
                                                      &PyInt_Type, &ordobj ) )
         return 0;
 
+    if ( Message_checkMutable ( self ) )
+        return 0;
     if ( fudgepyc_convertPythonToTimeEx ( &time,
                                           precision,
                                           hourobj,
@@ -772,6 +1200,8 @@ PyObject * Message_addFieldRawDateTime ( Message * self, PyObject * args, PyObje
                                                      &nameobj,
                                                      &PyInt_Type, &ordobj ) )
         return 0;
+    if ( Message_checkMutable ( self ) )
+        return 0;
     if ( fudgepyc_convertPythonToDateTimeEx ( &datetime,
                                               precision,
                                               yearobj,
@@ -798,49 +1228,17 @@ PyObject * Message_addFieldRawDateTime ( Message * self, PyObject * args, PyObje
     Py_RETURN_NONE;
 }
 
-static const char DOC_fudgepyc_message_addField [] =
-    "\nAdds a field to the Message. If the type is specified (should be\n"
-    "Fudge type, see fudgepyc.types) then the field is assumed to be that.\n"
-    "If no type is specified then the field type is determined by the type\n"
-    "of the value. The Python types map to Fudge as follows:\n"
-    "\n"
-    "  - None: Indicator\n"
-    "  - bool: Boolean\n"
-    "  - int: Byte/Short/Int/Long (depends on bits required to hold value)\n"
-    "  - long: See previous\n"
-    "  - float: Double\n"
-    "  - String: String\n"
-    "  - Unicode: String\n"
-    "  - fudgepyc.Message: FudgeMsg\n"
-    "  - datetime.date: Date\n"
-    "  - datetime.time: Time\n"
-    "  - datetime.datetime: DateTime\n"
-    "\n"
-    "All other types must be added using an explicity set type, or using one\n"
-    "of the named type adder methods. Field name and ordinal are optional.\n"
-    "\n"
-    "@param value: field value\n"
-    "@param name: field name String, defaults to None\n"
-    "@param ordinal: field ordinal integer, defaults to None\n"
-    "@param type: Fudge type id (0-255), defaults to None\n"
-    "@return: None or Exception on failure\n";
-PyObject * Message_addField ( Message * self, PyObject * args, PyObject * kwds )
+/* Adds a field using the type-dispatch shared by Message.addField and
+ * Message.addFields; nameobj, ordobj and typeobj may be null */
+static PyObject * Message_addFieldObjects ( Message * self,
+                                            PyObject * valobj,
+                                            PyObject * nameobj,
+                                            PyObject * ordobj,
+                                            PyObject * typeobj )
 {
-    static char * kwlist [] = { "value", "name", "ordinal", "type", 0 };
-
-    PyObject * ordobj = 0,
-             * nameobj = 0,
-             * typeobj = 0,
-             * valobj;
+    MessageFieldAdder adder;
     fudge_type_id fudgetype;
 
-    if ( ! PyArg_ParseTupleAndKeywords ( args, kwds, "O|OO!O!", kwlist,
-                                         &valobj,
-                                         &nameobj,
-                                         &PyInt_Type, &ordobj,
-                                         &PyInt_Type, &typeobj ) )
-        return 0;
-
     /* Either get the type from the type object parameter, or attempt to
        determine the type from that of the Python value object */
     if ( typeobj )
@@ -877,51 +1275,217 @@ PyObject * Message_addField ( Message * self, PyObject * args, PyObject * kwds )
     }
 
     /* Pass off to correct addField implementation for fudge type */
-    switch ( fudgetype )
+    if ( ! ( adder = Message_getFieldAdder ( fudgetype ) ) )
     {
-        case FUDGE_TYPE_INDICATOR:      return Message_addFieldIndicatorImpl ( self, nameobj, ordobj );
-        case FUDGE_TYPE_BOOLEAN:        return Message_addFieldBoolImpl ( self, valobj, nameobj, ordobj );
-        case FUDGE_TYPE_BYTE:           return Message_addFieldByteImpl ( self, valobj, nameobj, ordobj );
-        case FUDGE_TYPE_SHORT:          return Message_addFieldI16Impl ( self, valobj, nameobj, ordobj );
-        case FUDGE_TYPE_INT:            return Message_addFieldI32Impl ( self, valobj, nameobj, ordobj );
-        case FUDGE_TYPE_LONG:           return Message_addFieldI64Impl ( self, valobj, nameobj, ordobj );
-        case FUDGE_TYPE_FLOAT:          return Message_addFieldF32Impl ( self, valobj, nameobj, ordobj );
-        case FUDGE_TYPE_DOUBLE:         return Message_addFieldF64Impl ( self, valobj, nameobj, ordobj );
-        case FUDGE_TYPE_STRING:         return Message_addFieldStringImpl ( self, valobj, nameobj, ordobj );
-        case FUDGE_TYPE_FUDGE_MSG:      return Message_addFieldMsgImpl ( self, valobj, nameobj, ordobj );
-
-        case FUDGE_TYPE_BYTE_ARRAY:     return Message_addFieldByteArrayImpl ( self, valobj, nameobj, ordobj );
-        case FUDGE_TYPE_SHORT_ARRAY:    return Message_addFieldI16ArrayImpl ( self, valobj, nameobj, ordobj );
-        case FUDGE_TYPE_INT_ARRAY:      return Message_addFieldI32ArrayImpl ( self, valobj, nameobj, ordobj );
-        case FUDGE_TYPE_LONG_ARRAY:     return Message_addFieldI64ArrayImpl ( self, valobj, nameobj, ordobj );
-        case FUDGE_TYPE_FLOAT_ARRAY:    return Message_addFieldF32ArrayImpl ( self, valobj, nameobj, ordobj );
-        case FUDGE_TYPE_DOUBLE_ARRAY:   return Message_addFieldF64ArrayImpl ( self, valobj, nameobj, ordobj );
-
-        case FUDGE_TYPE_BYTE_ARRAY_4:   return Message_addField4ByteArrayImpl ( self, valobj, nameobj, ordobj );
-        case FUDGE_TYPE_BYTE_ARRAY_8:   return Message_addField8ByteArrayImpl ( self, valobj, nameobj, ordobj );
-        case FUDGE_TYPE_BYTE_ARRAY_16:  return Message_addField16ByteArrayImpl ( self, valobj, nameobj, ordobj );
-        case FUDGE_TYPE_BYTE_ARRAY_20:  return Message_addField20ByteArrayImpl ( self, valobj, nameobj, ordobj );
-        case FUDGE_TYPE_BYTE_ARRAY_32:  return Message_addField32ByteArrayImpl ( self, valobj, nameobj, ordobj );
-        case FUDGE_TYPE_BYTE_ARRAY_64:  return Message_addField64ByteArrayImpl ( self, valobj, nameobj, ordobj );
-        case FUDGE_TYPE_BYTE_ARRAY_128: return Message_addField128ByteArrayImpl ( self, valobj, nameobj, ordobj );
-        case FUDGE_TYPE_BYTE_ARRAY_256: return Message_addField256ByteArrayImpl ( self, valobj, nameobj, ordobj );
-        case FUDGE_TYPE_BYTE_ARRAY_512: return Message_addField512ByteArrayImpl ( self, valobj, nameobj, ordobj );
-
-        case FUDGE_TYPE_DATE:           return Message_addFieldDateImpl ( self, valobj, nameobj, ordobj );
-        case FUDGE_TYPE_TIME:           return Message_addFieldTimeImpl ( self, valobj, nameobj, ordobj );
-        case FUDGE_TYPE_DATETIME:       return Message_addFieldDateTimeImpl ( self, valobj, nameobj, ordobj );
-
-        default:
-            exception_raise_any ( PyExc_TypeError,
-                                  "No addField implemention found for Fudge "
-                                  "type %d", fudgetype );
-            return 0;
+        exception_raise_any ( PyExc_TypeError,
+                              "No addField implemention found for Fudge "
+                              "type %d", fudgetype );
+        return 0;
     }
+    return Message_addFieldWithAdder ( self, adder, valobj, nameobj, ordobj );
 }
 
-static const char DOC_fudgepyc_message_getFieldAtIndex [] =
-    "\nGet the field at the given index. Throws an exception if the index is\n"
-    "invalid.\n\n"
+/* Adder for Message.addFieldDateTimeFromEpoch; as an adder only takes one
+ * value, valobj is a tuple of the nanos, precision and offset arguments */
+static int Message_addFieldDateTimeFromEpochRaw ( Message * self,
+                                                  PyObject * valobj,
+                                                  FudgeString name,
+                                                  const fudge_i16 * ordinal )
+{
+    PyObject * nanosobj, * offsetobj;
+    unsigned int precision;
+    FudgeDateTime datetime;
+
+    if ( ! PyArg_ParseTuple ( valobj, "OIO", &nanosobj, &precision, &offsetobj ) )
+        return -1;
+    if ( fudgepyc_convertPythonToDateTimeFromEpoch ( &datetime,
+                                                     precision,
+                                                     nanosobj,
+                                                     offsetobj != Py_None ? offsetobj : 0 ) )
+        return -1;
+
+    return exception_raiseOnError ( FudgeMsg_addFieldDateTime ( self->msg,
+                                                                name,
+                                                                ordinal,
+                                                                &datetime ) );
+}
+
+static const char DOC_fudgepyc_message_addFieldDateTimeFromEpoch [] =
+    "\nAdds a DateTime field to the message from a count of nanoseconds since\n"
+    "the Unix epoch (1970-01-01 00:00:00 UTC). Unlike datetime.datetime this\n"
+    "keeps full nanosecond precision. See Field.getEpochNanos for the reverse.\n\n"
+    "If an offset is given the field holds the local time in that timezone,\n"
+    "with the timezone recorded; otherwise it holds the UTC time, with no\n"
+    "timezone.\n\n"
+    "@param nanos: integer nanoseconds since the epoch, may be negative\n"
+    "@param precision: precision as an integer, see fudge.types for valid values,\n"
+    "                  defaults to fudgepyc.types.PRECISION_NANOSECOND\n"
+    "@param offset: number of fifteen minute intervals that the localtime differs\n"
+    "               from UTC by (e.g. UTC-5h would be -20). Defaults to None (no\n"
+    "               timezone information)\n"
+    "@param name: field name String, defaults to None\n"
+    "@param ordinal: field ordinal integer, defaults to None\n"
+    "@return: None or Exception on failure\n";
+PyObject * Message_addFieldDateTimeFromEpoch ( Message * self, PyObject * args, PyObject * kwds )
+{
+    static char * kwlist [] = { "nanos", "precision", "offset", "name", "ordinal", 0 };
+
+    PyObject * nanosobj,
+             * offsetobj = Py_None,
+             * nameobj = 0,
+             * ordobj = 0,
+             * valobj,
+             * result;
+    unsigned int precision = FUDGE_DATETIME_PRECISION_NANOSECOND;
+
+    if ( ! PyArg_ParseTupleAndKeywords ( args, kwds, "O|IOOO!", kwlist,
+                                         &nanosobj,
+                                         &precision,
+                                         &offsetobj,
+                                         &nameobj,
+                                         &PyInt_Type, &ordobj ) )
+        return 0;
+
+    if ( ! ( valobj = Py_BuildValue ( "(OIO)", nanosobj, precision, offsetobj ) ) )
+        return 0;
+    result = Message_addFieldWithAdder ( self,
+                                         Message_addFieldDateTimeFromEpochRaw,
+                                         valobj, nameobj, ordobj );
+    Py_DECREF( valobj );
+    return result;
+}
+
+static const char DOC_fudgepyc_message_addField [] =
+    "\nAdds a field to the Message. If the type is specified (should be\n"
+    "Fudge type, see fudgepyc.types) then the field is assumed to be that.\n"
+    "If no type is specified then the field type is determined by the type\n"
+    "of the value. The Python types map to Fudge as follows:\n"
+    "\n"
+    "  - None: Indicator\n"
+    "  - bool: Boolean\n"
+    "  - int: Byte/Short/Int/Long (depends on bits required to hold value)\n"
+    "  - long: See previous\n"
+    "  - float: Double\n"
+    "  - String: String\n"
+    "  - Unicode: String\n"
+    "  - fudgepyc.Message: FudgeMsg\n"
+    "  - datetime.date: Date\n"
+    "  - datetime.time: Time\n"
+    "  - datetime.datetime: DateTime\n"
+    "\n"
+    "All other types must be added using an explicity set type, or using one\n"
+    "of the named type adder methods. Field name and ordinal are optional.\n"
+    "\n"
+    "@param value: field value\n"
+    "@param name: field name String, defaults to None\n"
+    "@param ordinal: field ordinal integer, defaults to None\n"
+    "@param type: Fudge type id (0-255), defaults to None\n"
+    "@return: None or Exception on failure\n";
+PyObject * Message_addField ( Message * self, PyObject * args, PyObject * kwds )
+{
+    static char * kwlist [] = { "value", "name", "ordinal", "type", 0 };
+
+    PyObject * ordobj = 0,
+             * nameobj = 0,
+             * typeobj = 0,
+             * valobj;
+
+    if ( ! PyArg_ParseTupleAndKeywords ( args, kwds, "O|OO!O!", kwlist,
+                                         &valobj,
+                                         &nameobj,
+                                         &PyInt_Type, &ordobj,
+                                         &PyInt_Type, &typeobj ) )
+        return 0;
+
+    return Message_addFieldObjects ( self, valobj, nameobj, ordobj, typeobj );
+}
+
+static const char DOC_fudgepyc_message_addFields [] =
+    "\nAdds a sequence of fields to the Message in a single call. Each field\n"
+    "is either a tuple of ( value[, name[, ordinal[, type]]] ) or a dict with\n"
+    "a \"value\" key and optional \"name\", \"ordinal\" and \"type\" keys;\n"
+    "these are used as the parameters of the same name for Message.addField.\n"
+    "A name, ordinal or type of None is treated as not present.\n\n"
+    "If a field cannot be added, the fields preceding it will remain in the\n"
+    "Message.\n\n"
+    "@param fields: iterable of field tuples/dicts\n"
+    "@return: None or Exception on failure\n";
+PyObject * Message_addFields ( Message * self, PyObject * args, PyObject * kwds )
+{
+    static char * kwlist [] = { "fields", 0 };
+
+    PyObject * fields, * sequence, * item, * result,
+             * valobj, * nameobj, * ordobj, * typeobj;
+    Py_ssize_t index, size;
+
+    if ( ! PyArg_ParseTupleAndKeywords ( args, kwds, "O", kwlist, &fields ) )
+        return 0;
+    if ( Message_checkMutable ( self ) )
+        return 0;
+    if ( ! ( sequence = PySequence_Fast ( fields, "Fields must be iterable" ) ) )
+        return 0;
+
+    for ( index = 0; index < PySequence_Fast_GET_SIZE( sequence ); ++index )
+    {
+        item = PySequence_Fast_GET_ITEM( sequence, index );
+        nameobj = ordobj = typeobj = 0;
+
+        if ( PyTuple_Check ( item ) &&
+             ( size = PyTuple_GET_SIZE( item ) ) >= 1 && size <= 4 )
+        {
+            valobj = PyTuple_GET_ITEM( item, 0 );
+            if ( size > 1 ) nameobj = PyTuple_GET_ITEM( item, 1 );
+            if ( size > 2 ) ordobj = PyTuple_GET_ITEM( item, 2 );
+            if ( size > 3 ) typeobj = PyTuple_GET_ITEM( item, 3 );
+        }
+        else if ( PyDict_Check ( item ) &&
+                  ( valobj = PyDict_GetItemString ( item, "value" ) ) )
+        {
+            nameobj = PyDict_GetItemString ( item, "name" );
+            ordobj = PyDict_GetItemString ( item, "ordinal" );
+            typeobj = PyDict_GetItemString ( item, "type" );
+        }
+        else
+        {
+            exception_raise_any ( PyExc_TypeError,
+                                  "Field %zd must be a tuple of 1-4 items or "
+                                  "a dict with a \"value\" key", index );
+            goto clear_sequence_and_fail;
+        }
+
+        if ( nameobj == Py_None ) nameobj = 0;
+        if ( ordobj == Py_None ) ordobj = 0;
+        if ( typeobj == Py_None ) typeobj = 0;
+
+        if ( ( ordobj && ! PyInt_Check ( ordobj ) ) ||
+             ( typeobj && ! PyInt_Check ( typeobj ) ) )
+        {
+            exception_raise_any ( PyExc_TypeError,
+                                  "Ordinal and type of field %zd must be "
+                                  "integers", index );
+            goto clear_sequence_and_fail;
+        }
+
+        if ( ! ( result = Message_addFieldObjects ( self,
+                                                    valobj,
+                                                    nameobj,
+                                                    ordobj,
+                                                    typeobj ) ) )
+            goto clear_sequence_and_fail;
+        Py_DECREF( result );
+    }
+
+    Py_DECREF( sequence );
+    Py_RETURN_NONE;
+
+clear_sequence_and_fail:
+    Py_DECREF( sequence );
+    return 0;
+}
+
+static const char DOC_fudgepyc_message_getFieldAtIndex [] =
+    "\nGet the field at the given index. Throws an exception if the index is\n"
+    "invalid.\n\n"
     "@param index: field index integer\n"
     "@return fudgepyc.Field or throws fudgepyc.Exception if index not valid\n";
 PyObject * Message_getFieldAtIndex ( Message * self, PyObject * args, PyObject * kwds )
@@ -955,7 +1519,7 @@ PyObject * Message_getFieldByName ( Message * self, PyObject * args, PyObject *
 
     if ( ! PyArg_ParseTupleAndKeywords ( args, kwds, "O", kwlist, &obj ) )
         return 0;
-    if ( fudgepyc_convertPythonToString ( &name, obj ) )
+    if ( namecache_getString ( &name, obj ) )
         return 0;
 
     obj = Message_getFieldWithName ( self, name, 0 );
@@ -1014,18 +1578,601 @@ free_mem_and_return:
     return target;
 }
 
+/* A field lookup key: either a name or an ordinal */
+typedef struct
+{
+    FudgeString name;
+    fudge_i16 ordinal;
+} MessageKey;
+
+static int Message_parseKey ( MessageKey * key, PyObject * keyobj )
+{
+    key->name = 0;
+    if ( PyInt_Check ( keyobj ) )
+        return Message_parseOrdinalObject ( &key->ordinal, keyobj );
+    if ( PyString_Check ( keyobj ) || PyUnicode_Check ( keyobj ) )
+        return Message_parseNameObject ( &key->name, keyobj );
+
+    exception_raise_any ( PyExc_ValueError,
+                          "Key must be an Integer ordinal or a String/Unicode "
+                          "name" );
+    return -1;
+}
+
+static int Message_isKeyMatch ( const MessageKey * key, const FudgeField * field )
+{
+    if ( key->name )
+        return ( field->flags & FUDGE_FIELD_HAS_NAME ) &&
+               ! FudgeString_compare ( field->name, key->name );
+    return ( field->flags & FUDGE_FIELD_HAS_ORDINAL ) &&
+           field->ordinal == key->ordinal;
+}
+
+/* Copies out every field matching the key, in a single pass over the
+ * message. The caller must PyMem_Free matches, even if there are none. */
+static int Message_findAll ( Message * self,
+                             PyObject * keyobj,
+                             FudgeField * * matches,
+                             Py_ssize_t * nummatches )
+{
+    MessageKey key;
+    FieldIndex * index;
+    FudgeField * copy = 0;
+    const FudgeField * fields;
+    fudge_i32 numfields, offset;
+
+    *matches = 0;
+    *nummatches = 0;
+
+    if ( Message_parseKey ( &key, keyobj ) )
+        return -1;
+
+    /* Use the lookup index's snapshot of the fields if there is one */
+    if ( Message_getIndex ( self, &index ) )
+        goto release_key_and_fail;
+    if ( index )
+    {
+        fields = index->fields;
+        numfields = index->numfields;
+    }
+    else
+    {
+        numfields = ( fudge_i32 ) FudgeMsg_numFields ( self->msg );
+        if ( ! ( copy = PyMem_New ( FudgeField, numfields + 1 ) ) )
+        {
+            PyErr_NoMemory ( );
+            goto release_key_and_fail;
+        }
+        numfields = FudgeMsg_getFields ( copy, numfields, self->msg );
+        fields = copy;
+    }
+
+    if ( ! ( *matches = PyMem_New ( FudgeField, numfields + 1 ) ) )
+    {
+        PyErr_NoMemory ( );
+        goto release_key_and_fail;
+    }
+    for ( offset = 0; offset < numfields; ++offset )
+        if ( Message_isKeyMatch ( &key, fields + offset ) )
+            ( *matches ) [ ( *nummatches )++ ] = fields [ offset ];
+
+    PyMem_Free ( copy );
+    FudgeString_release ( key.name );
+    return 0;
+
+release_key_and_fail:
+    PyMem_Free ( copy );
+    FudgeString_release ( key.name );
+    return -1;
+}
+
+/* Returns the widest numeric type among the fields, provided they are all
+ * integers or all floating point; otherwise returns FUDGE_TYPE_INDICATOR.
+ * Integer fields are not compared by exact type as Fudge-C stores each in
+ * the smallest type that can hold its value. */
+static fudge_type_id Message_getCommonNumericType ( const FudgeField * fields,
+                                                    Py_ssize_t numfields )
+{
+    fudge_type_id common = FUDGE_TYPE_INDICATOR;
+    Py_ssize_t index;
+    int rank, commonrank = 0;
+
+    for ( index = 0; index < numfields; ++index )
+    {
+        switch ( fields [ index ].type )
+        {
+            case FUDGE_TYPE_BYTE:   rank = 1; break;
+            case FUDGE_TYPE_SHORT:  rank = 2; break;
+            case FUDGE_TYPE_INT:    rank = 3; break;
+            case FUDGE_TYPE_LONG:   rank = 4; break;
+            case FUDGE_TYPE_FLOAT:  rank = 11; break;
+            case FUDGE_TYPE_DOUBLE: rank = 12; break;
+            default:                return FUDGE_TYPE_INDICATOR;
+        }
+
+        /* Ranks 1-4 are integers, 11-12 floating point */
+        if ( index && ( rank > 10 ) != ( commonrank > 10 ) )
+            return FUDGE_TYPE_INDICATOR;
+        if ( rank > commonrank )
+        {
+            commonrank = rank;
+            common = fields [ index ].type;
+        }
+    }
+    return common;
+}
+
+/* Returns the array.array typecode for a numeric Fudge type, or null if
+ * the type has no equivalent */
+static const char * Message_getArrayTypecode ( fudge_type_id type )
+{
+    switch ( type )
+    {
+        case FUDGE_TYPE_BYTE:   return "b";
+        case FUDGE_TYPE_SHORT:  return sizeof ( short ) == 2 ? "h" : 0;
+        case FUDGE_TYPE_INT:    return sizeof ( int ) == 4 ? "i" : 0;
+        case FUDGE_TYPE_LONG:   return sizeof ( long ) == 8 ? "l" : 0;
+        case FUDGE_TYPE_FLOAT:  return "f";
+        case FUDGE_TYPE_DOUBLE: return "d";
+        default:                return 0;
+    }
+}
+
+/* Packs the values of fields in to an array.array of typecode, widening
+ * each value to type (as returned by Message_getCommonNumericType) */
+static PyObject * Message_createTypedArray ( const FudgeField * fields,
+                                             Py_ssize_t numfields,
+                                             fudge_type_id type,
+                                             const char * typecode )
+{
+    PyObject * target;
+    const FudgeField * field;
+    char * bytes, * item;
+    Py_ssize_t index;
+    size_t itemsize;
+    fudge_i64 integer = 0;
+    fudge_f64 real = 0;
+
+    switch ( type )
+    {
+        case FUDGE_TYPE_BYTE:   itemsize = sizeof ( fudge_byte ); break;
+        case FUDGE_TYPE_SHORT:  itemsize = sizeof ( fudge_i16 ); break;
+        case FUDGE_TYPE_INT:    itemsize = sizeof ( fudge_i32 ); break;
+        case FUDGE_TYPE_LONG:   itemsize = sizeof ( fudge_i64 ); break;
+        case FUDGE_TYPE_FLOAT:  itemsize = sizeof ( fudge_f32 ); break;
+        default:                itemsize = sizeof ( fudge_f64 ); break;
+    }
+
+    if ( ! ( bytes = ( char * ) PyMem_Malloc ( itemsize * numfields ) ) )
+        return PyErr_NoMemory ( );
+
+    for ( index = 0; index < numfields; ++index )
+    {
+        field = fields + index;
+        item = bytes + index * itemsize;
+
+        switch ( field->type )
+        {
+            case FUDGE_TYPE_BYTE:   integer = field->data.byte; break;
+            case FUDGE_TYPE_SHORT:  integer = field->data.i16; break;
+            case FUDGE_TYPE_INT:    integer = field->data.i32; break;
+            case FUDGE_TYPE_LONG:   integer = field->data.i64; break;
+            case FUDGE_TYPE_FLOAT:  real = field->data.f32; break;
+            default:                real = field->data.f64; break;
+        }
+
+        switch ( type )
+        {
+            case FUDGE_TYPE_BYTE:   *( fudge_byte * ) item = ( fudge_byte ) integer; break;
+            case FUDGE_TYPE_SHORT:  *( fudge_i16 * ) item = ( fudge_i16 ) integer; break;
+            case FUDGE_TYPE_INT:    *( fudge_i32 * ) item = ( fudge_i32 ) integer; break;
+            case FUDGE_TYPE_LONG:   *( fudge_i64 * ) item = integer; break;
+            case FUDGE_TYPE_FLOAT:  *( fudge_f32 * ) item = ( fudge_f32 ) real; break;
+            default:                *( fudge_f64 * ) item = real; break;
+        }
+    }
+
+    target = PyObject_CallFunction ( s_arraytype,
+                                     "ss#",
+                                     typecode,
+                                     bytes,
+                                     ( Py_ssize_t ) ( itemsize * numfields ) );
+    PyMem_Free ( bytes );
+    return target;
+}
+
+static const char DOC_fudgepyc_message_getAll [] =
+    "\nGet every field with the given name or ordinal, in insertion order.\n"
+    "The message is searched in a single pass.\n\n"
+    "@param key: field name String/Unicode or ordinal integer\n"
+    "@return: [fudgepyc.Field, ...], empty if no fields match\n";
+PyObject * Message_getAll ( Message * self, PyObject * args, PyObject * kwds )
+{
+    static char * kwlist [] = { "key", 0 };
+
+    PyObject * keyobj, * target = 0, * field;
+    FudgeField * matches;
+    Py_ssize_t nummatches, index;
+
+    if ( ! PyArg_ParseTupleAndKeywords ( args, kwds, "O", kwlist, &keyobj ) )
+        return 0;
+    if ( Message_findAll ( self, keyobj, &matches, &nummatches ) )
+        return 0;
+
+    if ( ! ( target = PyList_New ( nummatches ) ) )
+        goto free_matches_and_return;
+
+    for ( index = 0; index < nummatches; ++index )
+    {
+        if ( ! ( field = Field_create ( matches [ index ], self ) ) )
+        {
+            Py_CLEAR( target );
+            goto free_matches_and_return;
+        }
+        PyList_SET_ITEM( target, index, field );
+    }
+
+free_matches_and_return:
+    PyMem_Free ( matches );
+    return target;
+}
+
+static const char DOC_fudgepyc_message_getAllValues [] =
+    "\nGet the values of every field with the given name or ordinal, in\n"
+    "insertion order. Values are converted as by Field.value, without\n"
+    "creating any Field objects.\n\n"
+    "If typed is True and the matching fields are all integers (Byte, Short,\n"
+    "Int or Long) or all floating point (Float or Double), the values are\n"
+    "returned in an array.array of the widest of their types instead of a\n"
+    "list.\n\n"
+    "@param key: field name String/Unicode or ordinal integer\n"
+    "@param typed: return an array.array where possible, defaults to False\n"
+    "@return: list (or array.array) of values, empty if no fields match\n";
+PyObject * Message_getAllValues ( Message * self, PyObject * args, PyObject * kwds )
+{
+    static char * kwlist [] = { "key", "typed", 0 };
+
+    PyObject * keyobj, * target = 0, * value;
+    FudgeField * matches;
+    Py_ssize_t nummatches, index;
+    const char * typecode = 0;
+    fudge_type_id type = FUDGE_TYPE_INDICATOR;
+    int typed = 0;
+
+    if ( ! PyArg_ParseTupleAndKeywords ( args, kwds, "O|i", kwlist,
+                                         &keyobj, &typed ) )
+        return 0;
+    if ( Message_findAll ( self, keyobj, &matches, &nummatches ) )
+        return 0;
+
+    if ( typed && nummatches )
+    {
+        type = Message_getCommonNumericType ( matches, nummatches );
+        typecode = Message_getArrayTypecode ( type );
+    }
+
+    if ( typecode )
+    {
+        target = Message_createTypedArray ( matches, nummatches, type, typecode );
+        goto free_matches_and_return;
+    }
+
+    if ( ! ( target = PyList_New ( nummatches ) ) )
+        goto free_matches_and_return;
+
+    for ( index = 0; index < nummatches; ++index )
+    {
+        if ( ! ( value = Field_convertMessageValue ( matches + index, self ) ) )
+        {
+            Py_CLEAR( target );
+            goto free_matches_and_return;
+        }
+        PyList_SET_ITEM( target, index, value );
+    }
+
+free_matches_and_return:
+    PyMem_Free ( matches );
+    return target;
+}
+
+/* Creates the Python wrapper of every sub-message field of self that does
+ * not have one yet. Returns 0 on success, -1 with an exception set on
+ * failure. */
+static int Message_wrapSubMessages ( Message * self )
+{
+    FudgeField * fields;
+    PyObject * wrapper;
+    fudge_i32 numfields = ( fudge_i32 ) FudgeMsg_numFields ( self->msg ),
+              index;
+    int result = -1;
+
+    if ( ! ( fields = PyMem_New ( FudgeField, numfields + 1 ) ) )
+    {
+        PyErr_NoMemory ( );
+        return -1;
+    }
+    numfields = FudgeMsg_getFields ( fields, numfields, self->msg );
+
+    for ( index = 0; index < numfields; ++index )
+    {
+        if ( fields [ index ].type != FUDGE_TYPE_FUDGE_MSG )
+            continue;
+        if ( ! ( wrapper = Message_retrieveMessage ( self,
+                                                     fields [ index ].data.message ) ) )
+            goto free_fields_and_return;
+        Py_DECREF( wrapper );
+    }
+    result = 0;
+
+free_fields_and_return:
+    PyMem_Free ( fields );
+    return result;
+}
+
+/* Returns a new Message, of the same type as self, holding a copy of its
+ * FudgeMsg. Copies of frozen messages are always deep: the copy is not
+ * frozen, so sharing sub-messages with it would let them be modified. */
+static PyObject * Message_copyObject ( Message * self, int deep )
+{
+    PyObject * args;
+    Message * target;
+    FudgeMsg msg;
+
+    deep = deep || self->frozen;
+
+    /* A shallow copy shares the sub-messages, so must also share their
+       Python wrappers; otherwise freezing one message would not freeze
+       the wrappers created later through the other */
+    if ( ! deep && Message_wrapSubMessages ( self ) )
+        return 0;
+
+    if ( exception_raiseOnError ( Message_copyMsg ( &msg, self->msg, deep ) ) )
+        return 0;
+
+    if ( ! ( args = PyTuple_New ( 0 ) ) )
+    {
+        FudgeMsg_release ( msg );
+        return 0;
+    }
+    target = ( Message * ) Py_TYPE( self )->tp_new ( Py_TYPE( self ), args, 0 );
+    Py_DECREF( args );
+    if ( ! target )
+    {
+        FudgeMsg_release ( msg );
+        return 0;
+    }
+    target->msg = msg;
+    target->epochnanos = self->epochnanos;
+    target->asciistr = self->asciistr;
+
+    if ( ! deep && self->msgdict &&
+         ! ( target->msgdict = PyDict_Copy ( self->msgdict ) ) )
+        Py_CLEAR( target );
+
+    return ( PyObject * ) target;
+}
+
+static const char DOC_fudgepyc_message_copy [] =
+    "\nCopy the message. Field names and String values are shared between the\n"
+    "copies, as they cannot be modified; everything else is copied. Fields\n"
+    "added to the copy do not affect the original, and vice versa.\n\n"
+    "If deep is False then sub-messages are also shared, so adding fields to\n"
+    "a sub-message of the copy also adds them to the original's sub-message.\n"
+    "Sub-messages of a frozen message are always copied, as the copy is not\n"
+    "frozen.\n\n"
+    "@param deep: also copy sub-messages, defaults to True\n"
+    "@return: new fudgepyc.Message\n";
+PyObject * Message_copy ( Message * self, PyObject * args, PyObject * kwds )
+{
+    static char * kwlist [] = { "deep", 0 };
+
+    int deep = 1;
+
+    if ( ! PyArg_ParseTupleAndKeywords ( args, kwds, "|i", kwlist, &deep ) )
+        return 0;
+    return Message_copyObject ( self, deep );
+}
+
+static const char DOC_fudgepyc_message___copy__ [] =
+    "\nSupport for copy.copy; equivalent to Message.copy(deep=False), so a\n"
+    "frozen message is copied in full\n\n"
+    "@return: new fudgepyc.Message\n";
+PyObject * Message___copy__ ( Message * self )
+{
+    return Message_copyObject ( self, 0 );
+}
+
+static const char DOC_fudgepyc_message___deepcopy__ [] =
+    "\nSupport for copy.deepcopy; equivalent to Message.copy(deep=True).\n"
+    "Sub-messages held more than once by the message are copied once, and\n"
+    "the copy is recorded in memo so the message itself is only copied once.\n\n"
+    "@param memo: deepcopy memo dictionary, or None\n"
+    "@return: new fudgepyc.Message\n";
+PyObject * Message___deepcopy__ ( Message * self, PyObject * memo )
+{
+    PyObject * key, * target;
+
+    if ( memo == Py_None )
+        return Message_copyObject ( self, 1 );
+    if ( ! PyDict_Check ( memo ) )
+    {
+        exception_raise_any ( PyExc_TypeError, "memo must be a dictionary or None" );
+        return 0;
+    }
+
+    /* Keyed by id(self), as the copy module does */
+    if ( ! ( key = PyLong_FromVoidPtr ( self ) ) )
+        return 0;
+
+    if ( ( target = PyDict_GetItem ( memo, key ) ) )
+        Py_INCREF( target );
+    else if ( ( target = Message_copyObject ( self, 1 ) ) &&
+              PyDict_SetItem ( memo, key, target ) )
+        Py_CLEAR( target );
+
+    Py_DECREF( key );
+    return target;
+}
+
+/* Freezes the message and the wrappers of any sub-messages it holds; those
+ * not yet wrapped are frozen by Message_retrieveMessage */
+static void Message_freezeObject ( Message * self )
+{
+    PyObject * key, * value;
+    Py_ssize_t pos = 0;
+
+    if ( self->frozen )
+        return;
+    self->frozen = 1;
+
+    if ( self->msgdict )
+        while ( PyDict_Next ( self->msgdict, &pos, &key, &value ) )
+            Message_freezeObject ( ( Message * ) value );
+}
+
+static const char DOC_fudgepyc_message_freeze [] =
+    "\nFreeze the message, so that no more fields can be added to it or to\n"
+    "its sub-messages. Frozen messages are hashable, with the hash being\n"
+    "calculated once, from the message content (see Message.contentHash).\n"
+    "Freezing cannot be undone; copy the message to get a mutable version.\n\n"
+    "@return: None\n";
+PyObject * Message_freeze ( Message * self )
+{
+    Message_freezeObject ( self );
+    Py_RETURN_NONE;
+}
+
+static const char DOC_fudgepyc_message_isFrozen [] =
+    "\nCheck if the message has been frozen; see Message.freeze\n\n"
+    "@return: True if frozen, otherwise False\n";
+PyObject * Message_isFrozen ( Message * self )
+{
+    return PyBool_FromLong ( self->frozen );
+}
+
+/* Returns 0 on success, -1 with an exception set on failure */
+static int Message_getContentHash ( Message * self, uint64_t * hash )
+{
+    if ( self->hashed )
+    {
+        *hash = self->contenthash;
+        return 0;
+    }
+
+    if ( exception_raiseOnError ( content_hash ( hash, self->msg ) ) )
+        return -1;
+
+    /* Only a frozen message's content is known not to change */
+    if ( self->frozen )
+    {
+        self->contenthash = *hash;
+        self->hashed = 1;
+    }
+    return 0;
+}
+
+static const char DOC_fudgepyc_message_contentHash [] =
+    "\nGet a 64-bit hash of the message's content: the names, ordinals, types\n"
+    "and values of its fields, in order, including those of sub-messages.\n"
+    "Messages that compare equal have the same content hash, and encode to\n"
+    "the same bytes. The message is not encoded to calculate the hash.\n\n"
+    "Unlike hash(), this works for messages that are not frozen; the hash is\n"
+    "only cached once the message is frozen.\n\n"
+    "@return: non-negative long\n";
+PyObject * Message_contentHash ( Message * self )
+{
+    uint64_t hash;
+    if ( Message_getContentHash ( self, &hash ) )
+        return 0;
+    return PyLong_FromUnsignedLongLong ( hash );
+}
+
+static const char DOC_fudgepyc_message_iterValues [] =
+    "\nIterate over the values of the fields in the message, in insertion\n"
+    "order. Values are converted as by Field.value, but no Field objects are\n"
+    "created. Iterating over the message itself yields the Fields.\n\n"
+    "Only the fields present when this is called are iterated over; fields\n"
+    "added during iteration will not be seen.\n\n"
+    "@return: iterator of field values\n";
+PyObject * Message_iterValues ( Message * self )
+{
+    return Message_createIterator ( self, 1 );
+}
+
+PyObject * Message_iter ( Message * self )
+{
+    return Message_createIterator ( self, 0 );
+}
+
+/* Messages are equal if their fields have the same names, ordinals, types
+ * and values, in the same order; no other comparisons are supported */
+PyObject * Message_richcompare ( Message * self, PyObject * other, int op )
+{
+    PyObject * result;
+    int equal;
+
+    if ( ( op != Py_EQ && op != Py_NE ) ||
+         ! PyObject_TypeCheck ( other, &MessageType ) )
+    {
+        Py_INCREF( Py_NotImplemented );
+        return Py_NotImplemented;
+    }
+
+    if ( exception_raiseOnError ( content_isEqual ( &equal,
+                                                    self->msg,
+                                                    ( ( Message * ) other )->msg ) ) )
+        return 0;
+
+    result = ( op == Py_EQ ) == ( equal != 0 ) ? Py_True : Py_False;
+    Py_INCREF( result );
+    return result;
+}
+
+long Message_hash ( Message * self )
+{
+    uint64_t hash;
+    long result;
+
+    if ( ! self->frozen )
+    {
+        exception_raise_any ( PyExc_TypeError,
+                              "Message is unhashable until frozen" );
+        return -1;
+    }
+
+    if ( Message_getContentHash ( self, &hash ) )
+        return -1;
+
+    /* Fold the 64-bit hash in to a long; -1 is reserved for errors */
+    result = ( long ) ( hash ^ ( hash >> 32 ) );
+    return result == -1 ? -2 : result;
+}
+
+static const char DOC_fudgepyc_message_encodedSize [] =
+    "\nGet the number of bytes the message's fields will occupy when encoded,\n"
+    "without encoding it. This excludes the envelope header; see\n"
+    "Envelope.encodedSize for the size of a complete encoded envelope.\n\n"
+    "@return: number of bytes\n";
+PyObject * Message_encodedSize ( Message * self )
+{
+    size_t size;
+    if ( Message_calculateEncodedSize ( self->msg, &size ) )
+        return 0;
+    return PyInt_FromSize_t ( size );
+}
+
 PyObject * Message_str ( Message * self )
 {
     PyObject * fields,
+             * field,
              * fieldstr,
              * joinstr,
              * string = 0;
-    size_t index, numfields;
+    int first = 1;
 
-    /* Retrieve all the fields as Python objects */
-    if ( ! ( fields = Message_getFields ( self ) ) )
+    /* Fields are created one at a time, as they're stringized */
+    if ( ! ( fields = Message_createIterator ( self, 0 ) ) )
         return 0;
-    numfields = PyList_Size ( fields );
 
     /* This will be used to join the field strings */
     if ( ! ( joinstr = PyString_FromString ( ", " ) ) )
@@ -1034,20 +2181,25 @@ PyObject * Message_str ( Message * self )
     if ( ! ( string = PyString_FromFormat ( "Message[" ) ) )
         goto clear_joinstr_and_return;
 
-    for ( index = 0; index < numfields; ++index )
+    while ( ( field = PyIter_Next ( fields ) ) )
     {
-        if ( index )
+        if ( ! first )
         {
             PyString_Concat ( &string, joinstr );
             if ( ! string )
+            {
+                Py_DECREF( field );
                 goto clear_joinstr_and_return;
+            }
         }
+        first = 0;
 
         /* As the fields are Python objects, can use the stringize method */
-        fieldstr = PyObject_Str ( PyList_GET_ITEM( fields, index ) );
+        fieldstr = PyObject_Str ( field );
+        Py_DECREF( field );
         if ( ! fieldstr )
         {
-            Py_DECREF( string );
+            Py_CLEAR( string );
             goto clear_joinstr_and_return;
         }
 
@@ -1056,7 +2208,9 @@ PyObject * Message_str ( Message * self )
             goto clear_joinstr_and_return;
     }
 
-    if ( ( fieldstr = PyString_FromString ( "]" ) ) )
+    if ( PyErr_Occurred ( ) )
+        Py_CLEAR( string );
+    else if ( ( fieldstr = PyString_FromString ( "]" ) ) )
         PyString_ConcatAndDel ( &string, fieldstr );
 
 clear_joinstr_and_return:
@@ -1109,13 +2263,28 @@ static PyMethodDef Message_methods [] =
     { "addFieldRawDate",      ( PyCFunction ) Message_addFieldRawDate,      METH_VARARGS | METH_KEYWORDS, DOC_fudgepyc_message_addFieldRawDate },
     { "addFieldRawTime",      ( PyCFunction ) Message_addFieldRawTime,      METH_VARARGS | METH_KEYWORDS, DOC_fudgepyc_message_addFieldRawTime },
     { "addFieldRawDateTime",  ( PyCFunction ) Message_addFieldRawDateTime,  METH_VARARGS | METH_KEYWORDS, DOC_fudgepyc_message_addFieldRawDateTime },
+    { "addFieldDateTimeFromEpoch", ( PyCFunction ) Message_addFieldDateTimeFromEpoch, METH_VARARGS | METH_KEYWORDS, DOC_fudgepyc_message_addFieldDateTimeFromEpoch },
 
     { "addField",             ( PyCFunction ) Message_addField,             METH_VARARGS | METH_KEYWORDS, DOC_fudgepyc_message_addField },
+    { "addFields",            ( PyCFunction ) Message_addFields,            METH_VARARGS | METH_KEYWORDS, DOC_fudgepyc_message_addFields },
 
     { "getFieldAtIndex",      ( PyCFunction ) Message_getFieldAtIndex,      METH_VARARGS | METH_KEYWORDS, DOC_fudgepyc_message_getFieldAtIndex },
     { "getFieldByName",       ( PyCFunction ) Message_getFieldByName,       METH_VARARGS | METH_KEYWORDS, DOC_fudgepyc_message_getFieldByName },
     { "getFieldByOrdinal",    ( PyCFunction ) Message_getFieldByOrdinal,    METH_VARARGS | METH_KEYWORDS, DOC_fudgepyc_message_getFieldByOrdinal },
     { "getFields",            ( PyCFunction ) Message_getFields,            METH_NOARGS,                  DOC_fudgepyc_message_getFields },
+    { "getAll",               ( PyCFunction ) Message_getAll,               METH_VARARGS | METH_KEYWORDS, DOC_fudgepyc_message_getAll },
+    { "getAllValues",         ( PyCFunction ) Message_getAllValues,         METH_VARARGS | METH_KEYWORDS, DOC_fudgepyc_message_getAllValues },
+    { "iterValues",           ( PyCFunction ) Message_iterValues,           METH_NOARGS,                  DOC_fudgepyc_message_iterValues },
+
+    { "copy",                 ( PyCFunction ) Message_copy,                 METH_VARARGS | METH_KEYWORDS, DOC_fudgepyc_message_copy },
+    { "__copy__",             ( PyCFunction ) Message___copy__,             METH_NOARGS,                  DOC_fudgepyc_message___copy__ },
+    { "__deepcopy__",         ( PyCFunction ) Message___deepcopy__,         METH_O,                       DOC_fudgepyc_message___deepcopy__ },
+
+    { "freeze",               ( PyCFunction ) Message_freeze,               METH_NOARGS,                  DOC_fudgepyc_message_freeze },
+    { "isFrozen",             ( PyCFunction ) Message_isFrozen,             METH_NOARGS,                  DOC_fudgepyc_message_isFrozen },
+    { "contentHash",          ( PyCFunction ) Message_contentHash,          METH_NOARGS,                  DOC_fudgepyc_message_contentHash },
+
+    { "encodedSize",          ( PyCFunction ) Message_encodedSize,          METH_NOARGS,                  DOC_fudgepyc_message_encodedSize },
     { NULL }
 };
 
@@ -1142,7 +2311,7 @@ PyTypeObject MessageType =
     0,                                              /* tp_as_number */
     0,                                              /* tp_as_sequence */
     &Message_as_mapping,                            /* tp_as_mapping */
-    0,                                              /* tp_hash */
+    ( hashfunc ) Message_hash,                      /* tp_hash */
     0,                                              /* tp_call */
     ( reprfunc ) Message_str,                       /* tp_str */
     0,                                              /* tp_getattro */
@@ -1152,9 +2321,9 @@ PyTypeObject MessageType =
     DOC_fudgepyc_message,                           /* tp_doc */
     0,                                              /* tp_traverse */
     0,                                              /* tp_clear */
-    0,                                              /* tp_richcompare */
+    ( richcmpfunc ) Message_richcompare,            /* tp_richcompare */
     0,                                              /* tp_weaklistoffset */
-    0,                                              /* tp_iter */
+    ( getiterfunc ) Message_iter,                   /* tp_iter */
     0,                                              /* tp_iternext */
     Message_methods,                                /* tp_methods */
     0,                                              /* tp_members */
@@ -1190,7 +2359,7 @@ void Message_storeMessage ( Message * self, Message * field )
     if ( Message_createMsgDict ( self ) )
         return;
 
-    if ( ! ( rawptr = PyInt_FromLong ( ( long ) field->msg ) ) )
+    if ( ! ( rawptr = PyLong_FromVoidPtr ( field->msg ) ) )
         return;
 
     result = PyDict_SetItem ( self->msgdict, rawptr, ( PyObject * ) field );
@@ -1204,7 +2373,7 @@ PyObject * Message_retrieveMessage ( Message * self, FudgeMsg msg )
     if ( Message_createMsgDict ( self ) )
         return 0;
 
-    if ( ! ( rawptr = PyInt_FromLong ( ( long ) msg ) ) )
+    if ( ! ( rawptr = PyLong_FromVoidPtr ( msg ) ) )
         return 0;
 
     if ( ( target = PyDict_GetItem ( self->msgdict, rawptr ) ) )
@@ -1216,6 +2385,11 @@ PyObject * Message_retrieveMessage ( Message * self, FudgeMsg msg )
     if ( ! ( target = Message_create ( msg ) ) )
         goto clean_and_return;
 
+    /* Sub-messages of a frozen message are also frozen; they also return
+       date/time and string values in the same form */
+    ( ( Message * ) target )->frozen = self->frozen;
+    ( ( Message * ) target )->epochnanos = self->epochnanos;
+    ( ( Message * ) target )->asciistr = self->asciistr;
     PyDict_SetItem ( self->msgdict, rawptr, target );
 
 clean_and_return:
@@ -1223,9 +2397,30 @@ clean_and_return:
     return target;
 }
 
+int Message_calculateEncodedSize ( FudgeMsg msg, size_t * size )
+{
+    if ( wire_messageSize ( size, msg ) == WIRE_OK )
+        return 0;
+    PyErr_NoMemory ( );
+    return -1;
+}
+
 int Message_modinit ( PyObject * module )
 {
+    PyObject * arraymodule;
+
     PyDateTime_IMPORT;
-    return 0;
+
+    if ( ! s_arraytype )
+    {
+        if ( ! ( arraymodule = PyImport_ImportModule ( "array" ) ) )
+            return -1;
+        s_arraytype = PyObject_GetAttrString ( arraymodule, "array" );
+        Py_DECREF( arraymodule );
+        if ( ! s_arraytype )
+            return -1;
+    }
+
+    return PyType_Ready ( &MessageIteratorType );
 }
 
@@ -17,6 +17,8 @@
 #define INC_FUDGEPYC_MESSAGE_H
 
 #include "exception.h"
+#include "fieldindex.h"
+#include <stdint.h>
 #include <fudge/message.h>
 
 typedef struct
@@ -24,6 +26,13 @@ typedef struct
     PyObject_HEAD
     FudgeMsg msg;
     PyObject * msgdict;
+    FieldIndex * index;     /* Name/ordinal lookup index, built lazily */
+    int stalelookups;       /* Linear lookups since the index went stale */
+    int frozen;             /* True once fields can no longer be added */
+    int hashed;             /* True if contenthash is valid; frozen only */
+    uint64_t contenthash;
+    int epochnanos;         /* Return date/time values as epoch nanoseconds */
+    int asciistr;           /* Return ASCII-only strings as str, not unicode */
 } Message;
 
 extern PyTypeObject MessageType;
@@ -33,6 +42,33 @@ extern PyObject * Message_create ( FudgeMsg msg );
 extern void Message_storeMessage ( Message * self, Message * field );
 extern PyObject * Message_retrieveMessage ( Message * self, FudgeMsg msg );
 
+/* Adds a field of a specific Fudge type from a Python value; name may be
+ * null, as may ordinal. Returns 0 on success, -1 with an exception set on
+ * failure. */
+typedef int ( *MessageFieldAdder ) ( Message * self,
+                                     PyObject * value,
+                                     FudgeString name,
+                                     const fudge_i16 * ordinal );
+
+extern MessageFieldAdder Message_getFieldAdder ( fudge_type_id type );
+
+/* Sets type to the Fudge type used for a Python value when no type is
+ * given. Returns -1, without an exception set, if there is no mapping. */
+extern int Message_getFudgeType ( fudge_type_id * type, PyObject * value );
+
+extern int Message_parseOrdinalObject ( fudge_i16 * target, PyObject * source );
+extern int Message_parseNameObject ( FudgeString * target, PyObject * source );
+
+/* Creates target as a copy of source; see Message.copy. Never touches
+ * Python objects. */
+extern FudgeStatus Message_copyMsg ( FudgeMsg * target, FudgeMsg source, int deep );
+
+/* Returns 0 if fields can be added to the message, otherwise returns -1
+ * with a TypeError set */
+extern int Message_checkMutable ( Message * self );
+
+extern int Message_calculateEncodedSize ( FudgeMsg msg, size_t * size );
+
 extern int Message_modinit ( PyObject * module );
 
 #endif
@@ -0,0 +1,328 @@
+/**
+ * Copyright (C) 2012 - 2012, Vrai Stacey.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "messagetemplate.h"
+#include <fudge/codec.h>
+#include <fudge/envelope.h>
+
+/****************************************************************************
+ * Constructor/destructor implementations
+ */
+
+static const char DOC_fudgepyc_messagetemplate [] =
+    "\nMessageTemplate(fields) -> MessageTemplate\n\n"
+    "fudgepyc.MessageTemplate describes the shape of a Message that is built\n"
+    "many times with different values: the name, ordinal and Fudge type of\n"
+    "each field. Names are converted and the type handling resolved once, when\n"
+    "the template is created, so building a Message from a template avoids\n"
+    "the per-field costs of Message.addField.\n"
+    "\n"
+    "Example:\n"
+    "  >>> template = MessageTemplate ( [ ( 'bid', None, fudgepyc.types.DOUBLE ),\n"
+    "  ...                                ( 'ask', None, fudgepyc.types.DOUBLE ),\n"
+    "  ...                                ( None, 1, fudgepyc.types.STRING ) ] )\n"
+    "  >>> message = template.build ( ( 1.25, 1.5, 'GBPUSD' ) )\n"
+    "\n"
+    "@param fields: sequence of ( name, ordinal, type ) tuples; name and\n"
+    "               ordinal may be None, type is a Fudge type id (see\n"
+    "               fudgepyc.types)\n"
+    "@return: MessageTemplate instance\n";
+static int MessageTemplate_init ( MessageTemplate * self, PyObject * args, PyObject * kwds )
+{
+    static char * kwlist [] = { "fields", 0 };
+
+    PyObject * fields, * sequence, * item, * nameobj, * ordobj;
+    MessageTemplateField * field;
+    Py_ssize_t index;
+    int type, result = -1;
+
+    if ( ! PyArg_ParseTupleAndKeywords ( args, kwds, "O", kwlist, &fields ) )
+        return -1;
+    if ( self->fields )
+    {
+        exception_raise_any ( PyExc_RuntimeError,
+                              "MessageTemplate cannot be re-initialised" );
+        return -1;
+    }
+    if ( ! ( sequence = PySequence_Fast ( fields, "Fields must be a sequence" ) ) )
+        return -1;
+
+    self->numfields = PySequence_Fast_GET_SIZE( sequence );
+    if ( ! ( self->fields = PyMem_New ( MessageTemplateField,
+                                        self->numfields ? self->numfields : 1 ) ) )
+    {
+        PyErr_NoMemory ( );
+        goto clear_sequence_and_return;
+    }
+    memset ( self->fields, 0, sizeof ( MessageTemplateField ) *
+                              ( self->numfields ? self->numfields : 1 ) );
+
+    for ( index = 0; index < self->numfields; ++index )
+    {
+        item = PySequence_Fast_GET_ITEM( sequence, index );
+        field = self->fields + index;
+
+        if ( ! PyArg_ParseTuple ( item, "OOi", &nameobj, &ordobj, &type ) )
+            goto clear_sequence_and_return;
+
+        if ( type < 0 || type > 255 ||
+             ! ( field->adder = Message_getFieldAdder ( ( fudge_type_id ) type ) ) )
+        {
+            exception_raise_any ( PyExc_TypeError,
+                                  "No addField implemention found for Fudge "
+                                  "type %d", type );
+            goto clear_sequence_and_return;
+        }
+        field->type = ( fudge_type_id ) type;
+
+        if ( ordobj != Py_None )
+        {
+            if ( ! PyInt_Check ( ordobj ) )
+            {
+                exception_raise_any ( PyExc_TypeError,
+                                      "Field ordinals must be integers" );
+                goto clear_sequence_and_return;
+            }
+            if ( Message_parseOrdinalObject ( &field->ordinal, ordobj ) )
+                goto clear_sequence_and_return;
+            field->hasordinal = 1;
+        }
+
+        if ( nameobj != Py_None && Message_parseNameObject ( &field->name, nameobj ) )
+            goto clear_sequence_and_return;
+    }
+    result = 0;
+
+clear_sequence_and_return:
+    Py_DECREF( sequence );
+    return result;
+}
+
+static PyObject * MessageTemplate_new ( PyTypeObject * type, PyObject * args, PyObject * kwds )
+{
+    MessageTemplate * obj = ( MessageTemplate * ) type->tp_alloc ( type, 0 );
+    if ( obj )
+    {
+        obj->fields = 0;
+        obj->numfields = 0;
+    }
+    return ( PyObject * ) obj;
+}
+
+static void MessageTemplate_dealloc ( MessageTemplate * self )
+{
+    Py_ssize_t index;
+
+    if ( self->fields )
+    {
+        for ( index = 0; index < self->numfields; ++index )
+            FudgeString_release ( self->fields [ index ].name );
+        PyMem_Free ( self->fields );
+    }
+    self->ob_type->tp_free ( self );
+}
+
+/****************************************************************************
+ * Internal functions
+ */
+
+static PyObject * MessageTemplate_createMessage ( MessageTemplate * self,
+                                                  PyObject * values )
+{
+    PyObject * sequence, * message = 0, * value;
+    MessageTemplateField * field;
+    FudgeMsg msg;
+    Py_ssize_t index;
+
+    if ( ! ( sequence = PySequence_Fast ( values, "Values must be a sequence" ) ) )
+        return 0;
+    if ( PySequence_Fast_GET_SIZE( sequence ) != self->numfields )
+    {
+        exception_raise_any ( PyExc_ValueError,
+                              "Template has %zd fields but %zd values given",
+                              self->numfields,
+                              PySequence_Fast_GET_SIZE( sequence ) );
+        goto clear_sequence_and_return;
+    }
+
+    if ( exception_raiseOnError ( FudgeMsg_create ( &msg ) ) )
+        goto clear_sequence_and_return;
+    message = Message_create ( msg );
+    FudgeMsg_release ( msg );
+    if ( ! message )
+        goto clear_sequence_and_return;
+
+    for ( index = 0; index < self->numfields; ++index )
+    {
+        field = self->fields + index;
+        value = PySequence_Fast_GET_ITEM( sequence, index );
+
+        /* None omits all but indicator fields */
+        if ( value == Py_None && field->type != FUDGE_TYPE_INDICATOR )
+            continue;
+
+        if ( field->adder ( ( Message * ) message,
+                            value,
+                            field->name,
+                            field->hasordinal ? &field->ordinal : 0 ) )
+        {
+            Py_CLEAR( message );
+            break;
+        }
+    }
+
+clear_sequence_and_return:
+    Py_DECREF( sequence );
+    return message;
+}
+
+/****************************************************************************
+ * Method implementations
+ */
+
+static const char DOC_fudgepyc_messagetemplate_build [] =
+    "\nBuild a Message from the template using the given values, one for each\n"
+    "field in the template and in the same order. A value of None omits its\n"
+    "field from the Message, unless the field is an Indicator.\n\n"
+    "@param values: sequence of field values\n"
+    "@return: fudgepyc.Message instance\n";
+PyObject * MessageTemplate_build ( MessageTemplate * self, PyObject * args, PyObject * kwds )
+{
+    static char * kwlist [] = { "values", 0 };
+
+    PyObject * values;
+
+    if ( ! PyArg_ParseTupleAndKeywords ( args, kwds, "O", kwlist, &values ) )
+        return 0;
+    return MessageTemplate_createMessage ( self, values );
+}
+
+static const char DOC_fudgepyc_messagetemplate_encode [] =
+    "\nBuild a Message from the template using the given values (see\n"
+    "MessageTemplate.build) and encode it within an Envelope.\n\n"
+    "Note that this method will release the GIL during encoding.\n\n"
+    "@param values: sequence of field values\n"
+    "@param directives: processing directives, defaults to zero.\n"
+    "@param schema: schema version number, defaults to zero.\n"
+    "@param taxonomy: taxonomy reference indicator, defaults to zero.\n"
+    "@return: String instance containing the encoded Envelope\n";
+PyObject * MessageTemplate_encode ( MessageTemplate * self, PyObject * args, PyObject * kwds )
+{
+    static char * kwlist [] = { "values", "directives", "schema", "taxonomy", 0 };
+
+    PyObject * values, * message, * target = 0;
+    FudgeMsgEnvelope envelope;
+    FudgeStatus status;
+    fudge_byte directives = 0,
+               schema = 0,
+               * bytes;
+    fudge_i16 taxonomy = 0;
+    fudge_i32 numbytes;
+
+    if ( ! PyArg_ParseTupleAndKeywords ( args, kwds, "O|bbh", kwlist,
+                                         &values, &directives, &schema, &taxonomy ) )
+        return 0;
+
+    if ( ! ( message = MessageTemplate_createMessage ( self, values ) ) )
+        return 0;
+
+    status = FudgeMsgEnvelope_create ( &envelope,
+                                       directives,
+                                       schema,
+                                       taxonomy,
+                                       ( ( Message * ) message )->msg );
+    if ( exception_raiseOnError ( status ) )
+        goto clear_message_and_return;
+
+    Py_BEGIN_ALLOW_THREADS
+    status = FudgeCodec_encodeMsg ( envelope, &bytes, &numbytes );
+    Py_END_ALLOW_THREADS
+
+    FudgeMsgEnvelope_release ( envelope );
+    if ( exception_raiseOnError ( status ) )
+        goto clear_message_and_return;
+
+    target = PyString_FromStringAndSize ( ( const char * ) bytes, numbytes );
+    free ( bytes );
+
+clear_message_and_return:
+    Py_DECREF( message );
+    return target;
+}
+
+Py_ssize_t MessageTemplate_len ( MessageTemplate * self )
+{
+    return self->numfields;
+}
+
+/****************************************************************************
+ * Type and method list definitions
+ */
+
+static PyMethodDef MessageTemplate_methods [] =
+{
+    { "build",  ( PyCFunction ) MessageTemplate_build,  METH_VARARGS | METH_KEYWORDS, DOC_fudgepyc_messagetemplate_build },
+    { "encode", ( PyCFunction ) MessageTemplate_encode, METH_VARARGS | METH_KEYWORDS, DOC_fudgepyc_messagetemplate_encode },
+    { NULL }
+};
+
+PySequenceMethods MessageTemplate_as_sequence =
+{
+    ( lenfunc ) MessageTemplate_len,    // sq_length
+};
+
+PyTypeObject MessageTemplateType =
+{
+    PyObject_HEAD_INIT( NULL )
+    0,                                              /* ob_size */
+    "fudgepyc.MessageTemplate",                     /* tp_name */
+    sizeof ( MessageTemplate ),                     /* tp_basicsize */
+    0,                                              /* tp_itemsize */
+    ( destructor ) MessageTemplate_dealloc,         /* tp_dealloc */
+    0,                                              /* tp_print */
+    0,                                              /* tp_getattr */
+    0,                                              /* tp_setattr */
+    0,                                              /* tp_compare */
+    0,                                              /* tp_repr */
+    0,                                              /* tp_as_number */
+    &MessageTemplate_as_sequence,                   /* tp_as_sequence */
+    0,                                              /* tp_as_mapping */
+    0,                                              /* tp_hash */
+    0,                                              /* tp_call */
+    0,                                              /* tp_str */
+    0,                                              /* tp_getattro */
+    0,                                              /* tp_setattro */
+    0,                                              /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE,       /* tp_flags */
+    DOC_fudgepyc_messagetemplate,                   /* tp_doc */
+    0,                                              /* tp_traverse */
+    0,                                              /* tp_clear */
+    0,                                              /* tp_richcompare */
+    0,                                              /* tp_weaklistoffset */
+    0,                                              /* tp_iter */
+    0,                                              /* tp_iternext */
+    MessageTemplate_methods,                        /* tp_methods */
+    0,                                              /* tp_members */
+    0,                                              /* tp_getset */
+    0,                                              /* tp_base */
+    0,                                              /* tp_dict */
+    0,                                              /* tp_descr_get */
+    0,                                              /* tp_descr_set */
+    0,                                              /* tp_dictoffset */
+    ( initproc ) MessageTemplate_init,              /* tp_init */
+    PyType_GenericAlloc,                            /* tp_alloc */
+    MessageTemplate_new                             /* tp_new */
+};
+
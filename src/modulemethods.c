@@ -14,7 +14,13 @@
  * limitations under the License.
  */
 #include "modulemethods.h"
+#include "envelope.h"
+#include "namecache.h"
+#include <fudge/codec.h>
 #include <fudge/fudge.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <unistd.h>
 
 PyObject * fudgepyc_init ( )
 {
@@ -23,3 +29,260 @@ PyObject * fudgepyc_init ( )
     Py_RETURN_NONE;
 }
 
+
+PyObject * fudgepyc_nameCacheStats ( )
+{
+    NameCacheStats stats;
+
+    namecache_getStats ( &stats );
+    return Py_BuildValue ( "{s:k,s:k,s:k,s:n,s:n}",
+                           "hits", stats.hits,
+                           "misses", stats.misses,
+                           "evictions", stats.evictions,
+                           "size", ( Py_ssize_t ) stats.size,
+                           "capacity", ( Py_ssize_t ) stats.capacity );
+}
+
+PyObject * fudgepyc_clearNameCache ( )
+{
+    namecache_clear ( );
+    Py_RETURN_NONE;
+}
+
+/* A single buffer to be decoded by the pool */
+typedef struct
+{
+    const fudge_byte * bytes;
+    fudge_i32 numbytes;
+    FudgeMsgEnvelope envelope;
+    FudgeStatus status;
+} DecodeJob;
+
+/* Upper limit on the threads used by a call, whatever the processor count.
+ * Workers are never stopped, so this also bounds the size of the pool. */
+#define DECODEPOOL_MAX_THREADS 64
+
+/* Worker threads are started on first use and then kept for the life of
+ * the process, so that a call only has to post its jobs and wake them.
+ * Only one batch is in progress at a time; batchlock serialises callers,
+ * while lock guards the remaining fields. */
+typedef struct
+{
+    pthread_mutex_t batchlock;
+    pthread_mutex_t lock;
+    pthread_cond_t work;        /* Signalled when a batch is posted */
+    pthread_cond_t done;        /* Signalled when a batch's last job ends */
+    long numthreads;            /* Workers started so far */
+    long active;                /* Workers taking part in this batch */
+    DecodeJob * jobs;
+    Py_ssize_t count;
+    Py_ssize_t next;            /* Index of the next job to be claimed */
+    Py_ssize_t remaining;       /* Jobs not yet finished */
+} DecodePool;
+
+static DecodePool s_decodepool = { PTHREAD_MUTEX_INITIALIZER,
+                                   PTHREAD_MUTEX_INITIALIZER,
+                                   PTHREAD_COND_INITIALIZER,
+                                   PTHREAD_COND_INITIALIZER,
+                                   0, 0, 0, 0, 0, 0 };
+static pthread_once_t s_decodepoolonce = PTHREAD_ONCE_INIT;
+
+/* Decoding is safe from many threads at once. FudgeCodec_decodeMsg only
+ * reads the source bytes and the global type registry, which is populated
+ * by Fudge_init and never modified by the decoder. Every other allocation
+ * it makes belongs to the envelope it returns, which is only touched by
+ * the thread that decoded it until the batch completes. Must be called
+ * with pool.lock held; it is released while decoding. */
+static void fudgepyc_runDecodeJob ( DecodePool * pool, Py_ssize_t index )
+{
+    DecodeJob * job = pool->jobs + index;
+
+    pthread_mutex_unlock ( &pool->lock );
+    job->status = FudgeCodec_decodeMsg ( &job->envelope, job->bytes, job->numbytes );
+    pthread_mutex_lock ( &pool->lock );
+
+    if ( ! --pool->remaining )
+        pthread_cond_signal ( &pool->done );
+}
+
+static void * fudgepyc_decodeWorker ( void * arg )
+{
+    DecodePool * pool = &s_decodepool;
+    long id = ( long ) ( intptr_t ) arg;
+
+    pthread_mutex_lock ( &pool->lock );
+    for ( ;; )
+    {
+        while ( pool->next >= pool->count || id >= pool->active )
+            pthread_cond_wait ( &pool->work, &pool->lock );
+        fudgepyc_runDecodeJob ( pool, pool->next++ );
+    }
+    return 0;
+}
+
+/* A forked child has none of the parent's workers, and may have inherited
+ * the locks mid-batch, so it starts over with an empty pool */
+static void fudgepyc_resetDecodePool ( void )
+{
+    DecodePool * pool = &s_decodepool;
+
+    pthread_mutex_init ( &pool->batchlock, 0 );
+    pthread_mutex_init ( &pool->lock, 0 );
+    pthread_cond_init ( &pool->work, 0 );
+    pthread_cond_init ( &pool->done, 0 );
+    pool->numthreads = pool->active = 0;
+    pool->jobs = 0;
+    pool->count = pool->next = pool->remaining = 0;
+}
+
+static void fudgepyc_registerDecodePoolFork ( void )
+{
+    pthread_atfork ( 0, 0, fudgepyc_resetDecodePool );
+}
+
+/* Starts workers until there are at least numthreads. Failing to start a
+ * worker is not an error, as the calling thread decodes any jobs that the
+ * workers do not. Must be called with pool.batchlock held. */
+static void fudgepyc_growDecodePool ( DecodePool * pool, long numthreads )
+{
+    pthread_attr_t attr;
+    pthread_t handle;
+
+    if ( pool->numthreads >= numthreads || pthread_attr_init ( &attr ) )
+        return;
+    pthread_attr_setdetachstate ( &attr, PTHREAD_CREATE_DETACHED );
+
+    while ( pool->numthreads < numthreads &&
+            ! pthread_create ( &handle,
+                               &attr,
+                               fudgepyc_decodeWorker,
+                               ( void * ) ( intptr_t ) pool->numthreads ) )
+        ++pool->numthreads;
+    pthread_attr_destroy ( &attr );
+}
+
+/* Decodes all of the jobs, using up to workers pool threads as well as the
+ * calling thread. The GIL must not be held. */
+static void fudgepyc_decodeJobs ( DecodeJob * jobs, Py_ssize_t count, long workers )
+{
+    DecodePool * pool = &s_decodepool;
+
+    pthread_once ( &s_decodepoolonce, fudgepyc_registerDecodePoolFork );
+    pthread_mutex_lock ( &pool->batchlock );
+    fudgepyc_growDecodePool ( pool, workers );
+
+    pthread_mutex_lock ( &pool->lock );
+    pool->jobs = jobs;
+    pool->count = pool->remaining = count;
+    pool->next = 0;
+    pool->active = workers;
+    if ( workers )
+        pthread_cond_broadcast ( &pool->work );
+
+    while ( pool->next < pool->count )
+        fudgepyc_runDecodeJob ( pool, pool->next++ );
+    while ( pool->remaining )
+        pthread_cond_wait ( &pool->done, &pool->lock );
+
+    pool->jobs = 0;
+    pool->count = pool->next = 0;
+    pool->active = 0;
+    pthread_mutex_unlock ( &pool->lock );
+    pthread_mutex_unlock ( &pool->batchlock );
+}
+
+PyObject * fudgepyc_decodeParallel ( PyObject * self, PyObject * args, PyObject * kwds )
+{
+    static char * kwlist [] = { "buffers", "threads", 0 };
+
+    PyObject * buffers, * sequence = 0, * envelopes = 0, * envobj;
+    Py_ssize_t count, index, numbytes;
+    DecodeJob * jobs = 0;
+    FudgeStatus status = FUDGE_OK;
+    const void * bytes;
+    long threads = 0, maxthreads;
+
+    if ( ! PyArg_ParseTupleAndKeywords ( args, kwds, "O|l", kwlist,
+                                         &buffers, &threads ) )
+        return 0;
+
+    /* Take a private copy of the sequence, so that the buffers stay alive
+       while the GIL is released */
+    if ( ! ( sequence = PySequence_List ( buffers ) ) )
+        return 0;
+    count = PyList_GET_SIZE( sequence );
+
+    /* Decoding is CPU bound, so more threads than processors cannot help;
+       as pool workers are kept, an unbounded request would also leave that
+       many threads behind in the process */
+    if ( ( maxthreads = sysconf ( _SC_NPROCESSORS_ONLN ) ) <= 0 )
+        maxthreads = 1;
+    if ( maxthreads > DECODEPOOL_MAX_THREADS )
+        maxthreads = DECODEPOOL_MAX_THREADS;
+    if ( threads <= 0 || threads > maxthreads )
+        threads = maxthreads;
+    if ( threads > count )
+        threads = count ? count : 1;
+
+    if ( ! ( jobs = PyMem_New ( DecodeJob, count ? count : 1 ) ) )
+    {
+        PyErr_NoMemory ( );
+        goto clean_and_return;
+    }
+
+    for ( index = 0; index < count; ++index )
+    {
+        if ( PyObject_AsReadBuffer ( PyList_GET_ITEM( sequence, index ),
+                                     &bytes,
+                                     &numbytes ) )
+        {
+            count = index;
+            goto clean_and_return;
+        }
+        if ( numbytes > INT32_MAX )
+        {
+            exception_raise_any ( PyExc_OverflowError,
+                                  "Buffer %zd is too large to decode",
+                                  index );
+            count = index;
+            goto clean_and_return;
+        }
+        jobs [ index ].bytes = ( const fudge_byte * ) bytes;
+        jobs [ index ].numbytes = ( fudge_i32 ) numbytes;
+        jobs [ index ].envelope = 0;
+        jobs [ index ].status = FUDGE_OK;
+    }
+
+    /* The calling thread decodes alongside threads - 1 pool workers */
+    Py_BEGIN_ALLOW_THREADS
+    fudgepyc_decodeJobs ( jobs, count, threads - 1 );
+    Py_END_ALLOW_THREADS
+
+    for ( index = 0; index < count && status == FUDGE_OK; ++index )
+        status = jobs [ index ].status;
+    if ( exception_raiseOnError ( status ) )
+        goto clean_and_return;
+
+    if ( ! ( envelopes = PyList_New ( count ) ) )
+        goto clean_and_return;
+    for ( index = 0; index < count; ++index )
+    {
+        if ( ! ( envobj = Envelope_create ( jobs [ index ].envelope ) ) )
+        {
+            Py_CLEAR( envelopes );
+            goto clean_and_return;
+        }
+        PyList_SET_ITEM( envelopes, index, envobj );
+    }
+
+clean_and_return:
+    if ( jobs )
+    {
+        for ( index = 0; index < count; ++index )
+            if ( jobs [ index ].envelope )
+                FudgeMsgEnvelope_release ( jobs [ index ].envelope );
+    }
+    PyMem_Free ( jobs );
+    Py_XDECREF( sequence );
+    return envelopes;
+}
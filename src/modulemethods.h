@@ -10,5 +10,36 @@ static const char DOC_fudgepyc_init [] =
     "@return: None or fudgepyc.Exception on error\n";
 extern PyObject * fudgepyc_init ( void );
 
+static const char DOC_fudgepyc_decodeParallel [] =
+    "\nDecode a sequence of encoded envelopes (one per buffer) using a pool of\n"
+    "native threads. The GIL is released once while every buffer is decoded,\n"
+    "with the results wrapped as Envelopes afterwards. Buffers must not be\n"
+    "modified while the call is in progress.\n\n"
+    "The pool's threads are started as they are first needed and are then\n"
+    "reused by later calls. Calls from different Python threads take turns\n"
+    "with the pool, rather than running at the same time.\n\n"
+    "@param buffers: sequence of buffer objects (e.g. String), each holding\n"
+    "                a single encoded envelope\n"
+    "@param threads: number of threads to decode with, at most the number of\n"
+    "                online processors (and never more than 64), defaults to\n"
+    "                that maximum\n"
+    "@return: list of Envelopes, in the same order as buffers, or\n"
+    "         fudgepyc.Exception if any buffer fails to decode, or\n"
+    "         OverflowError if a buffer is 2GB or larger\n";
+extern PyObject * fudgepyc_decodeParallel ( PyObject * self, PyObject * args, PyObject * kwds );
+
+static const char DOC_fudgepyc_nameCacheStats [] =
+    "\nGet statistics for the cache of encoded field names. Every name used\n"
+    "to add or look up a field is checked against the cache, saving the cost\n"
+    "of re-encoding frequently used names.\n\n"
+    "@return: dict with keys \"hits\", \"misses\", \"evictions\", \"size\"\n"
+    "         (number of cached names) and \"capacity\"\n";
+extern PyObject * fudgepyc_nameCacheStats ( void );
+
+static const char DOC_fudgepyc_clearNameCache [] =
+    "\nEmpty the cache of encoded field names and reset its statistics.\n\n"
+    "@return: None\n";
+extern PyObject * fudgepyc_clearNameCache ( void );
+
 #endif
 
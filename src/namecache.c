@@ -0,0 +1,126 @@
+/**
+ * Copyright (C) 2012 - 2012, Vrai Stacey.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "namecache.h"
+#include "converters.h"
+
+/* Must be a power of two */
+#define NAMECACHE_CAPACITY 1024
+
+/* Longer names can't be encoded, so there's no point caching them */
+#define NAMECACHE_MAX_LENGTH 256
+
+typedef struct
+{
+    PyObject * name;
+    FudgeString string;
+} NameCacheEntry;
+
+static NameCacheEntry namecache_entries [ NAMECACHE_CAPACITY ];
+static NameCacheStats namecache_stats = { 0, 0, 0, 0, NAMECACHE_CAPACITY };
+
+static int namecache_isCacheable ( PyObject * name )
+{
+    if ( PyString_CheckExact ( name ) )
+        return PyString_GET_SIZE( name ) <= NAMECACHE_MAX_LENGTH;
+    if ( PyUnicode_CheckExact ( name ) )
+        return PyUnicode_GET_SIZE( name ) <= NAMECACHE_MAX_LENGTH;
+    return 0;
+}
+
+/* Cacheable names are exact Strings or Unicodes, so can be compared without
+ * calling back in to Python */
+static int namecache_isEqual ( PyObject * x, PyObject * y )
+{
+    if ( x == y )
+        return 1;
+    if ( Py_TYPE( x ) != Py_TYPE( y ) )
+        return 0;
+    if ( PyString_CheckExact ( x ) )
+        return PyString_GET_SIZE( x ) == PyString_GET_SIZE( y ) &&
+               ! memcmp ( PyString_AS_STRING( x ),
+                          PyString_AS_STRING( y ),
+                          PyString_GET_SIZE( x ) );
+    return PyUnicode_GET_SIZE( x ) == PyUnicode_GET_SIZE( y ) &&
+           ! memcmp ( PyUnicode_AS_UNICODE( x ),
+                      PyUnicode_AS_UNICODE( y ),
+                      PyUnicode_GET_DATA_SIZE( x ) );
+}
+
+static void namecache_clearEntry ( NameCacheEntry * entry )
+{
+    if ( entry->name )
+    {
+        Py_CLEAR( entry->name );
+        FudgeString_release ( entry->string );
+        entry->string = 0;
+        --namecache_stats.size;
+    }
+}
+
+int namecache_getString ( FudgeString * target, PyObject * name )
+{
+    NameCacheEntry * entry;
+    long hash;
+
+    if ( ! namecache_isCacheable ( name ) )
+        return fudgepyc_convertPythonToString ( target, name );
+
+    /* String and Unicode objects cache their hash, so this is cheap for
+       names that are reused */
+    if ( ( hash = PyObject_Hash ( name ) ) == -1 )
+        return -1;
+    entry = namecache_entries + ( ( unsigned long ) hash & ( NAMECACHE_CAPACITY - 1 ) );
+
+    if ( entry->name && namecache_isEqual ( entry->name, name ) )
+    {
+        ++namecache_stats.hits;
+        FudgeString_retain ( ( *target = entry->string ) );
+        return 0;
+    }
+
+    ++namecache_stats.misses;
+    if ( fudgepyc_convertPythonToString ( target, name ) )
+        return -1;
+
+    if ( entry->name )
+    {
+        ++namecache_stats.evictions;
+        namecache_clearEntry ( entry );
+    }
+
+    Py_INCREF( ( entry->name = name ) );
+    FudgeString_retain ( ( entry->string = *target ) );
+    ++namecache_stats.size;
+    return 0;
+}
+
+void namecache_getStats ( NameCacheStats * stats )
+{
+    *stats = namecache_stats;
+}
+
+void namecache_clear ( void )
+{
+    size_t index;
+
+    for ( index = 0; index < NAMECACHE_CAPACITY; ++index )
+        namecache_clearEntry ( namecache_entries + index );
+
+    namecache_stats.hits = 0;
+    namecache_stats.misses = 0;
+    namecache_stats.evictions = 0;
+}
+
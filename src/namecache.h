@@ -0,0 +1,48 @@
+/**
+ * Copyright (C) 2012 - 2012, Vrai Stacey.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef INC_FUDGEPYC_NAMECACHE_H
+#define INC_FUDGEPYC_NAMECACHE_H
+
+#include <Python.h>
+#include <fudge/string.h>
+
+/* Process-wide cache of the FudgeStrings created for field names, keyed by
+ * the Python name objects. The cache is direct-mapped: each name hashes to
+ * a single slot and evicts whatever name previously occupied it. All
+ * functions must be called with the GIL held. */
+
+typedef struct
+{
+    unsigned long hits;
+    unsigned long misses;
+    unsigned long evictions;
+    size_t size;            /* Number of occupied slots */
+    size_t capacity;        /* Total number of slots */
+} NameCacheStats;
+
+/* Sets target to a retained FudgeString for the name object, which the
+ * caller must release. Names that cannot be cached (e.g. String
+ * subclasses) are converted directly. Returns 0 on success or -1 with a
+ * Python exception set. */
+extern int namecache_getString ( FudgeString * target, PyObject * name );
+
+extern void namecache_getStats ( NameCacheStats * stats );
+
+/* Empties the cache and resets the statistics */
+extern void namecache_clear ( void );
+
+#endif
+
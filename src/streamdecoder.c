@@ -0,0 +1,280 @@
+/**
+ * Copyright (C) 2012 - 2012, Vrai Stacey.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "streamdecoder.h"
+#include "wire.h"
+#include <fudge/codec.h>
+
+/* Initial buffer size; enough for a handful of typical envelopes */
+#define STREAMDECODER_INITIAL_CAPACITY 4096
+
+/****************************************************************************
+ * Constructor/destructor implementations
+ */
+
+static const char DOC_fudgepyc_streamdecoder [] =
+    "\nStreamDecoder() -> StreamDecoder\n\n"
+    "fudgepyc.StreamDecoder decodes Envelopes from a stream of bytes that\n"
+    "arrive in arbitrarily sized chunks (e.g. from a socket). Chunks are\n"
+    "passed to StreamDecoder.feed and the decoder is then iterated over to\n"
+    "retrieve each complete Envelope. Incomplete trailing bytes are kept\n"
+    "until the remainder of their envelope is fed in.\n"
+    "\n"
+    "Iteration stops when no complete Envelope is buffered, but resumes once\n"
+    "more bytes are fed in; so the same decoder may be iterated over many\n"
+    "times.\n"
+    "\n"
+    "An envelope that fails to decode is skipped. If an envelope header is\n"
+    "invalid the position of the next envelope cannot be known, so all\n"
+    "buffered bytes are discarded; decoding resumes with the next chunk fed\n"
+    "in, which should start at an envelope boundary.\n"
+    "\n"
+    "A StreamDecoder may not be fed while another thread is iterating over\n"
+    "it.\n"
+    "\n"
+    "Example:\n"
+    "  >>> decoder = StreamDecoder ( )\n"
+    "  >>> while True:\n"
+    "  ...     decoder.feed ( socket.recv ( 4096 ) )\n"
+    "  ...     for envelope in decoder:\n"
+    "  ...         handle ( envelope.message ( ) )\n"
+    "\n"
+    "@return: StreamDecoder instance\n";
+static PyObject * StreamDecoder_new ( PyTypeObject * type, PyObject * args, PyObject * kwds )
+{
+    StreamDecoder * obj = ( StreamDecoder * ) type->tp_alloc ( type, 0 );
+    if ( obj )
+    {
+        obj->buffer = 0;
+        obj->capacity = 0;
+        obj->start = 0;
+        obj->end = 0;
+        obj->decoding = 0;
+    }
+    return ( PyObject * ) obj;
+}
+
+static void StreamDecoder_dealloc ( StreamDecoder * self )
+{
+    PyMem_Free ( self->buffer );
+    self->ob_type->tp_free ( self );
+}
+
+/****************************************************************************
+ * Buffer management
+ */
+
+/* Makes room for at least numbytes after the buffered bytes. Consumed
+ * bytes at the front are reclaimed first, with the buffer only growing
+ * (doubling) if that isn't enough. */
+static int StreamDecoder_reserve ( StreamDecoder * self, size_t numbytes )
+{
+    size_t pending = self->end - self->start,
+           capacity;
+    fudge_byte * buffer;
+
+    if ( self->capacity - self->end >= numbytes )
+        return 0;
+
+    if ( self->start )
+    {
+        memmove ( self->buffer, self->buffer + self->start, pending );
+        self->start = 0;
+        self->end = pending;
+        if ( self->capacity - self->end >= numbytes )
+            return 0;
+    }
+
+    capacity = self->capacity ? self->capacity : STREAMDECODER_INITIAL_CAPACITY;
+    while ( capacity - pending < numbytes )
+        capacity *= 2;
+
+    if ( ! ( buffer = ( fudge_byte * ) PyMem_Realloc ( self->buffer, capacity ) ) )
+    {
+        PyErr_NoMemory ( );
+        return -1;
+    }
+    self->buffer = buffer;
+    self->capacity = capacity;
+    return 0;
+}
+
+/* Returns 0 if the buffer is not in use by a decode running without the
+ * GIL, otherwise returns -1 with a RuntimeError set */
+static int StreamDecoder_checkIdle ( StreamDecoder * self )
+{
+    if ( ! self->decoding )
+        return 0;
+    exception_raise_any ( PyExc_RuntimeError,
+                          "StreamDecoder is in use by another thread" );
+    return -1;
+}
+
+/****************************************************************************
+ * Method implementations
+ */
+
+static const char DOC_fudgepyc_streamdecoder_feed [] =
+    "\nAppend a chunk of bytes from the stream to the decoder. The chunk\n"
+    "does not need to align with envelope boundaries.\n\n"
+    "@param chunk: buffer object (e.g. String) containing the bytes\n"
+    "@return: None, or RuntimeError if the decoder is being iterated over\n"
+    "         by another thread\n";
+PyObject * StreamDecoder_feed ( StreamDecoder * self, PyObject * args )
+{
+    const void * bytes;
+    Py_ssize_t numbytes;
+    PyObject * chunk;
+
+    if ( ! PyArg_ParseTuple ( args, "O", &chunk ) )
+        return 0;
+    if ( ! PyObject_CheckReadBuffer ( chunk ) )
+    {
+        exception_raise_any ( PyExc_TypeError,
+                              "Cannot feed object that doesn't implement "
+                              "the Buffer protocol (e.g. String)" );
+        return 0;
+    }
+    if ( PyObject_AsReadBuffer ( chunk, &bytes, &numbytes ) )
+        return 0;
+
+    /* The buffer may be moved or reallocated, so must not be touched while
+       another thread is decoding from it */
+    if ( StreamDecoder_checkIdle ( self ) )
+        return 0;
+    if ( StreamDecoder_reserve ( self, ( size_t ) numbytes ) )
+        return 0;
+    memcpy ( self->buffer + self->end, bytes, numbytes );
+    self->end += numbytes;
+    Py_RETURN_NONE;
+}
+
+static const char DOC_fudgepyc_streamdecoder_pending [] =
+    "\nGet the number of buffered bytes that have not yet been decoded.\n\n"
+    "@return: number of bytes\n";
+PyObject * StreamDecoder_pending ( StreamDecoder * self )
+{
+    return PyInt_FromSsize_t ( self->end - self->start );
+}
+
+static PyObject * StreamDecoder_iternext ( StreamDecoder * self )
+{
+    FudgeMsgEnvelope envelope;
+    FudgeStatus status;
+    WireHeader header;
+    const fudge_byte * bytes;
+    size_t pending;
+    PyObject * target;
+
+    if ( StreamDecoder_checkIdle ( self ) )
+        return 0;
+    bytes = self->buffer + self->start;
+    pending = self->end - self->start;
+
+    /* Returning null without an exception set ends the iteration */
+    switch ( wire_readHeader ( &header, bytes, pending ) )
+    {
+        case WIRE_TRUNCATED:
+            return 0;
+        case WIRE_MALFORMED:
+            /* With no valid size there is no way to find the next envelope,
+               so drop everything rather than failing on every call */
+            self->start = self->end = 0;
+            exception_raise_any ( FudgePyc_Exception,
+                                  "Invalid envelope size %d in stream",
+                                  header.size );
+            return 0;
+        default:
+            break;
+    }
+    if ( pending < ( size_t ) header.size )
+        return 0;
+
+    /* Feeding is refused until the decode completes, so the buffer stays
+       put while the GIL is released */
+    self->decoding = 1;
+    Py_BEGIN_ALLOW_THREADS
+    status = FudgeCodec_decodeMsg ( &envelope, bytes, header.size );
+    Py_END_ALLOW_THREADS
+    self->decoding = 0;
+
+    /* Skip the envelope even if it failed to decode, so the stream can
+       carry on from the next one */
+    self->start += header.size;
+    if ( self->start == self->end )
+        self->start = self->end = 0;
+
+    if ( exception_raiseOnError ( status ) )
+        return 0;
+
+    target = Envelope_create ( envelope );
+    FudgeMsgEnvelope_release ( envelope );
+    return target;
+}
+
+/****************************************************************************
+ * Type and method list definitions
+ */
+
+static PyMethodDef StreamDecoder_methods [] =
+{
+    { "feed",    ( PyCFunction ) StreamDecoder_feed,    METH_VARARGS, DOC_fudgepyc_streamdecoder_feed },
+    { "pending", ( PyCFunction ) StreamDecoder_pending, METH_NOARGS,  DOC_fudgepyc_streamdecoder_pending },
+    { NULL }
+};
+
+PyTypeObject StreamDecoderType =
+{
+    PyObject_HEAD_INIT( NULL )
+    0,                                              /* ob_size */
+    "fudgepyc.StreamDecoder",                       /* tp_name */
+    sizeof ( StreamDecoder ),                       /* tp_basicsize */
+    0,                                              /* tp_itemsize */
+    ( destructor ) StreamDecoder_dealloc,           /* tp_dealloc */
+    0,                                              /* tp_print */
+    0,                                              /* tp_getattr */
+    0,                                              /* tp_setattr */
+    0,                                              /* tp_compare */
+    0,                                              /* tp_repr */
+    0,                                              /* tp_as_number */
+    0,                                              /* tp_as_sequence */
+    0,                                              /* tp_as_mapping */
+    0,                                              /* tp_hash */
+    0,                                              /* tp_call */
+    0,                                              /* tp_str */
+    0,                                              /* tp_getattro */
+    0,                                              /* tp_setattro */
+    0,                                              /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE,       /* tp_flags */
+    DOC_fudgepyc_streamdecoder,                     /* tp_doc */
+    0,                                              /* tp_traverse */
+    0,                                              /* tp_clear */
+    0,                                              /* tp_richcompare */
+    0,                                              /* tp_weaklistoffset */
+    PyObject_SelfIter,                              /* tp_iter */
+    ( iternextfunc ) StreamDecoder_iternext,        /* tp_iternext */
+    StreamDecoder_methods,                          /* tp_methods */
+    0,                                              /* tp_members */
+    0,                                              /* tp_getset */
+    0,                                              /* tp_base */
+    0,                                              /* tp_dict */
+    0,                                              /* tp_descr_get */
+    0,                                              /* tp_descr_set */
+    0,                                              /* tp_dictoffset */
+    0,                                              /* tp_init */
+    PyType_GenericAlloc,                            /* tp_alloc */
+    StreamDecoder_new                               /* tp_new */
+};
+
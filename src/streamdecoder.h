@@ -0,0 +1,34 @@
+/**
+ * Copyright (C) 2012 - 2012, Vrai Stacey.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef INC_FUDGEPYC_STREAMDECODER_H
+#define INC_FUDGEPYC_STREAMDECODER_H
+
+#include "envelope.h"
+
+typedef struct
+{
+    PyObject_HEAD
+    fudge_byte * buffer;
+    size_t capacity;
+    size_t start;       /* Offset of the first unconsumed byte */
+    size_t end;         /* Offset one past the last buffered byte */
+    int decoding;       /* True while the GIL is released to decode */
+} StreamDecoder;
+
+extern PyTypeObject StreamDecoderType;
+
+#endif
+
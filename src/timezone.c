@@ -0,0 +1,226 @@
+/**
+ * Copyright (C) 2012 - 2012, Vrai Stacey.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "timezone.h"
+#include <datetime.h>
+
+static PyObject * s_timezones [ TIMEZONE_MAX_QUARTERS * 2 + 1 ];
+
+
+/****************************************************************************
+ * Constructor/destructor implementations
+ */
+
+static const char DOC_fudgepyc_timezone [] =
+    "\nTimezone(quarters) -> Timezone\n\n"
+    "Basic datetime.tzinfo implementation for use by fudgepyc.Message and\n"
+    "fudgepyc.Field types. All datetime.time and datetime.datetime objects\n"
+    "returned from Fudge-Pyc (that have timezone information) will use this\n"
+    "class.\n\n"
+    "To match the FudgeTime/FudgeDateTime implementation, the UTC offset must\n"
+    "be specified in fifteen minute intervals. For example, UTC+1H would be\n"
+    "Timezone(4) while UTC-8H would be Timezone(-32). The number of quarters\n"
+    "must be an integer.\n\n"
+    "Timezones are immutable and there is only one instance for each offset,\n"
+    "so Timezone(4) is Timezone(4).\n\n"
+    "@param quarters: number of fifteen minute intervals before (negative) or\n"
+    "                 after (positive) UTC\n"
+    "@return: Timezone instance\n";
+static PyObject * Timezone_alloc ( PyTypeObject * type, int quarters )
+{
+    Timezone * obj;
+    int minutes = abs ( quarters ) * 15;
+
+    if ( ! ( obj = ( Timezone * ) type->tp_alloc ( type, 0 ) ) )
+        return 0;
+
+    obj->quarters = quarters;
+    obj->delta = PyDelta_FromDSU ( 0, quarters * 15 * 60, 0 );
+    obj->name = PyString_FromFormat ( "%s%d%02d",
+                                      quarters < 0 ? "-" : "",
+                                      minutes / 60,
+                                      minutes % 60 );
+    if ( ! obj->delta || ! obj->name )
+        Py_CLEAR( obj );
+    return ( PyObject * ) obj;
+}
+
+static PyObject * Timezone_new ( PyTypeObject * type, PyObject * args, PyObject * kwds )
+{
+    static char * kwlist [] = { "quarters", 0 };
+
+    int quarters;
+
+    if ( ! PyArg_ParseTupleAndKeywords ( args, kwds, "i", kwlist, &quarters ) )
+        return 0;
+
+    /* Subtypes may carry extra state, so always get a new instance */
+    if ( type != &TimezoneType )
+        return Timezone_alloc ( type, quarters );
+    return Timezone_fromQuarters ( quarters );
+}
+
+static void Timezone_dealloc ( Timezone * self )
+{
+    Py_XDECREF( self->delta );
+    Py_XDECREF( self->name );
+    self->ob_type->tp_free ( self );
+}
+
+
+/****************************************************************************
+ * Method implementations
+ */
+
+static const char DOC_fudgepyc_timezone_utcoffset [] =
+    "\nReturn offset of localtime from UTC, in minutes east of UTC; if local\n"
+    "time is west of UTC the return value is negative.\n\n"
+    "@param dt: localtime as a datetime.time object\n"
+    "@return: utcoffset as a datetime.timedelta object\n";
+PyObject * Timezone_utcoffset ( Timezone * self, PyObject * dt )
+{
+    Py_INCREF( self->delta );
+    return self->delta;
+}
+
+static const char DOC_fudgepyc_timezone_dst [] =
+    "\nReturn the DST adjustment, if any.\n\n"
+    "@param dt: localtime as a datetime.time object\n"
+    "@return: dst adjustment as a datetime.timedelta object, or None\n";
+PyObject * Timezone_dst ( Timezone * self, PyObject * dt )
+{
+    Py_RETURN_NONE;
+}
+
+static const char DOC_fudgepyc_timezone_tzname [] =
+    "\nReturn the name of the timezone, using the format: -?H+MM. For\n"
+    "example, UTC+1H would be \"100\" while UTC-11H would be \"-1100\".\n\n"
+    "@param dt: localtime as a datetime.time object\n"
+    "@return: string containing timezone name\n";
+PyObject * Timezone_tzname ( Timezone * self, PyObject * dt )
+{
+    Py_INCREF( self->name );
+    return self->name;
+}
+
+static const char DOC_fudgepyc_timezone___reduce__ [] =
+    "\nSupport for pickle and copy; Timezones are recreated from their offset\n\n"
+    "@return: ( Timezone, ( quarters, ) )\n";
+PyObject * Timezone___reduce__ ( Timezone * self )
+{
+    return Py_BuildValue ( "O(i)", Py_TYPE( self ), self->quarters );
+}
+
+PyObject * Timezone_repr ( Timezone * self )
+{
+    return PyString_FromFormat ( "%s(%d)", Py_TYPE( self )->tp_name, self->quarters );
+}
+
+
+/****************************************************************************
+ * Type and method list definitions
+ */
+
+static PyMethodDef Timezone_methods [] =
+{
+    { "utcoffset",  ( PyCFunction ) Timezone_utcoffset,  METH_O,      DOC_fudgepyc_timezone_utcoffset },
+    { "dst",        ( PyCFunction ) Timezone_dst,        METH_O,      DOC_fudgepyc_timezone_dst },
+    { "tzname",     ( PyCFunction ) Timezone_tzname,     METH_O,      DOC_fudgepyc_timezone_tzname },
+    { "__reduce__", ( PyCFunction ) Timezone___reduce__, METH_NOARGS, DOC_fudgepyc_timezone___reduce__ },
+    { NULL }
+};
+
+PyTypeObject TimezoneType =
+{
+    PyObject_HEAD_INIT( NULL )
+    0,                                              /* ob_size */
+    "fudgepyc.timezone.Timezone",                   /* tp_name */
+    sizeof ( Timezone ),                            /* tp_basicsize */
+    0,                                              /* tp_itemsize */
+    ( destructor ) Timezone_dealloc,                /* tp_dealloc */
+    0,                                              /* tp_print */
+    0,                                              /* tp_getattr */
+    0,                                              /* tp_setattr */
+    0,                                              /* tp_compare */
+    ( reprfunc ) Timezone_repr,                     /* tp_repr */
+    0,                                              /* tp_as_number */
+    0,                                              /* tp_as_sequence */
+    0,                                              /* tp_as_mapping */
+    0,                                              /* tp_hash */
+    0,                                              /* tp_call */
+    0,                                              /* tp_str */
+    0,                                              /* tp_getattro */
+    0,                                              /* tp_setattro */
+    0,                                              /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE,       /* tp_flags */
+    DOC_fudgepyc_timezone,                          /* tp_doc */
+    0,                                              /* tp_traverse */
+    0,                                              /* tp_clear */
+    0,                                              /* tp_richcompare */
+    0,                                              /* tp_weaklistoffset */
+    0,                                              /* tp_iter */
+    0,                                              /* tp_iternext */
+    Timezone_methods,                               /* tp_methods */
+    0,                                              /* tp_members */
+    0,                                              /* tp_getset */
+    0,                                              /* tp_base (tzinfo) */
+    0,                                              /* tp_dict */
+    0,                                              /* tp_descr_get */
+    0,                                              /* tp_descr_set */
+    0,                                              /* tp_dictoffset */
+    0,                                              /* tp_init */
+    PyType_GenericAlloc,                            /* tp_alloc */
+    Timezone_new                                    /* tp_new */
+};
+
+
+/****************************************************************************
+ * Type functions
+ */
+
+PyObject * Timezone_fromQuarters ( int quarters )
+{
+    PyObject * target;
+
+    if ( quarters < -TIMEZONE_MAX_QUARTERS || quarters > TIMEZONE_MAX_QUARTERS )
+        return Timezone_alloc ( &TimezoneType, quarters );
+
+    target = s_timezones [ quarters + TIMEZONE_MAX_QUARTERS ];
+    Py_INCREF( target );
+    return target;
+}
+
+int Timezone_modinit ( PyObject * module )
+{
+    int quarters;
+
+    PyDateTime_IMPORT;
+    if ( ! PyDateTimeAPI )
+        return -1;
+
+    TimezoneType.tp_base = PyDateTimeAPI->TZInfoType;
+    if ( PyType_Ready ( &TimezoneType ) )
+        return -1;
+
+    for ( quarters = -TIMEZONE_MAX_QUARTERS; quarters <= TIMEZONE_MAX_QUARTERS; ++quarters )
+    {
+        PyObject * * timezone = s_timezones + quarters + TIMEZONE_MAX_QUARTERS;
+        if ( ! *timezone && ! ( *timezone = Timezone_alloc ( &TimezoneType, quarters ) ) )
+            return -1;
+    }
+
+    Py_INCREF( &TimezoneType );
+    return PyModule_AddObject ( module, "Timezone", ( PyObject * ) &TimezoneType );
+}
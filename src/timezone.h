@@ -0,0 +1,43 @@
+/**
+ * Copyright (C) 2012 - 2012, Vrai Stacey.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef INC_FUDGEPYC_TIMEZONE_H
+#define INC_FUDGEPYC_TIMEZONE_H
+
+#include <Python.h>
+
+typedef struct
+{
+    PyObject_HEAD
+    int quarters;
+    PyObject * delta;   /* UTC offset as a datetime.timedelta */
+    PyObject * name;    /* Name returned by tzname */
+} Timezone;
+
+/* Offsets of a day or more are rejected by datetime, so are not cached */
+#define TIMEZONE_MAX_QUARTERS 95
+
+extern PyTypeObject TimezoneType;
+
+/* Returns a new reference to the Timezone for an offset in fifteen minute
+ * intervals. Valid offsets (less than a day either side of UTC) share a
+ * single immutable instance each. */
+extern PyObject * Timezone_fromQuarters ( int quarters );
+
+/* Readies the type, which is a datetime.tzinfo subtype, and adds it to the
+ * module. Must be called before any times are converted. */
+extern int Timezone_modinit ( PyObject * module );
+
+#endif
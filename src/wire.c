@@ -0,0 +1,298 @@
+/**
+ * Copyright (C) 2012 - 2012, Vrai Stacey.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "wire.h"
+#include <fudge/string.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Field prefix bits, as defined by the Fudge encoding specification */
+#define WIRE_PREFIX_FIXED_WIDTH     0x80
+#define WIRE_PREFIX_VAR_WIDTH_MASK  0x60
+#define WIRE_PREFIX_HAS_ORDINAL     0x10
+#define WIRE_PREFIX_HAS_NAME        0x08
+
+static fudge_i16 wire_readI16 ( const fudge_byte * bytes )
+{
+    const unsigned char * raw = ( const unsigned char * ) bytes;
+    return ( fudge_i16 ) ( ( raw [ 0 ] << 8 ) | raw [ 1 ] );
+}
+
+static fudge_i32 wire_readI32 ( const fudge_byte * bytes )
+{
+    const unsigned char * raw = ( const unsigned char * ) bytes;
+    return ( fudge_i32 ) ( ( ( unsigned long ) raw [ 0 ] << 24 ) |
+                           ( ( unsigned long ) raw [ 1 ] << 16 ) |
+                           ( ( unsigned long ) raw [ 2 ] << 8 ) |
+                             ( unsigned long ) raw [ 3 ] );
+}
+
+/* Returns the payload width of a fixed width type, or -1 if the type
+ * is not one of the built-in fixed width types */
+static fudge_i32 wire_getFixedWidth ( fudge_type_id type )
+{
+    switch ( type )
+    {
+        case FUDGE_TYPE_INDICATOR:      return 0;
+        case FUDGE_TYPE_BOOLEAN:        return 1;
+        case FUDGE_TYPE_BYTE:           return 1;
+        case FUDGE_TYPE_SHORT:          return 2;
+        case FUDGE_TYPE_INT:            return 4;
+        case FUDGE_TYPE_LONG:           return 8;
+        case FUDGE_TYPE_FLOAT:          return 4;
+        case FUDGE_TYPE_DOUBLE:         return 8;
+        case FUDGE_TYPE_BYTE_ARRAY_4:   return 4;
+        case FUDGE_TYPE_BYTE_ARRAY_8:   return 8;
+        case FUDGE_TYPE_BYTE_ARRAY_16:  return 16;
+        case FUDGE_TYPE_BYTE_ARRAY_20:  return 20;
+        case FUDGE_TYPE_BYTE_ARRAY_32:  return 32;
+        case FUDGE_TYPE_BYTE_ARRAY_64:  return 64;
+        case FUDGE_TYPE_BYTE_ARRAY_128: return 128;
+        case FUDGE_TYPE_BYTE_ARRAY_256: return 256;
+        case FUDGE_TYPE_BYTE_ARRAY_512: return 512;
+        case FUDGE_TYPE_DATE:           return 4;
+        case FUDGE_TYPE_TIME:           return 8;
+        case FUDGE_TYPE_DATETIME:       return 12;
+        default:                        return -1;
+    }
+}
+
+/* Returns the number of bytes used to encode a variable width */
+static size_t wire_getWidthSize ( size_t width )
+{
+    if ( ! width )
+        return 0;
+    if ( width <= 0xff )
+        return 1;
+    if ( width <= 0x7fff )
+        return 2;
+    return 4;
+}
+
+static void wire_writeI16 ( fudge_byte * bytes, fudge_i16 value )
+{
+    bytes [ 0 ] = ( fudge_byte ) ( ( value >> 8 ) & 0xff );
+    bytes [ 1 ] = ( fudge_byte ) ( value & 0xff );
+}
+
+static void wire_writeI32 ( fudge_byte * bytes, fudge_i32 value )
+{
+    bytes [ 0 ] = ( fudge_byte ) ( ( value >> 24 ) & 0xff );
+    bytes [ 1 ] = ( fudge_byte ) ( ( value >> 16 ) & 0xff );
+    bytes [ 2 ] = ( fudge_byte ) ( ( value >> 8 ) & 0xff );
+    bytes [ 3 ] = ( fudge_byte ) ( value & 0xff );
+}
+
+WireStatus wire_readHeader ( WireHeader * header,
+                             const fudge_byte * bytes,
+                             size_t numbytes )
+{
+    if ( numbytes < WIRE_HEADER_SIZE )
+        return WIRE_TRUNCATED;
+
+    header->directives = bytes [ 0 ];
+    header->schema = bytes [ 1 ];
+    header->taxonomy = wire_readI16 ( bytes + 2 );
+    header->size = wire_readI32 ( bytes + 4 );
+
+    if ( header->size < WIRE_HEADER_SIZE )
+        return WIRE_MALFORMED;
+    return WIRE_OK;
+}
+
+WireStatus wire_readField ( WireField * field,
+                            const fudge_byte * bytes,
+                            size_t numbytes )
+{
+    unsigned char prefix;
+    size_t offset = 2;
+
+    if ( numbytes < 2 )
+        return WIRE_TRUNCATED;
+
+    prefix = ( unsigned char ) bytes [ 0 ];
+    field->type = ( fudge_type_id ) bytes [ 1 ];
+
+    if ( ( field->hasordinal = ( prefix & WIRE_PREFIX_HAS_ORDINAL ) != 0 ) )
+    {
+        if ( numbytes < offset + 2 )
+            return WIRE_TRUNCATED;
+        field->ordinal = wire_readI16 ( bytes + offset );
+        offset += 2;
+    }
+    else
+        field->ordinal = 0;
+
+    if ( prefix & WIRE_PREFIX_HAS_NAME )
+    {
+        if ( numbytes < offset + 1 )
+            return WIRE_TRUNCATED;
+        field->namelen = ( unsigned char ) bytes [ offset++ ];
+        if ( numbytes < offset + field->namelen )
+            return WIRE_TRUNCATED;
+        field->name = bytes + offset;
+        offset += field->namelen;
+    }
+    else
+    {
+        field->name = 0;
+        field->namelen = 0;
+    }
+
+    field->widthlen = offset;
+    if ( prefix & WIRE_PREFIX_FIXED_WIDTH )
+    {
+        if ( ( field->numbytes = wire_getFixedWidth ( field->type ) ) < 0 )
+            return WIRE_MALFORMED;
+    }
+    else
+    {
+        switch ( prefix & WIRE_PREFIX_VAR_WIDTH_MASK )
+        {
+            case 0x00:
+                field->numbytes = 0;
+                break;
+
+            case 0x20:
+                if ( numbytes < offset + 1 )
+                    return WIRE_TRUNCATED;
+                field->numbytes = ( unsigned char ) bytes [ offset ];
+                offset += 1;
+                break;
+
+            case 0x40:
+                if ( numbytes < offset + 2 )
+                    return WIRE_TRUNCATED;
+                field->numbytes = ( unsigned short ) wire_readI16 ( bytes + offset );
+                offset += 2;
+                break;
+
+            default:
+                if ( numbytes < offset + 4 )
+                    return WIRE_TRUNCATED;
+                field->numbytes = wire_readI32 ( bytes + offset );
+                offset += 4;
+                break;
+        }
+        if ( field->numbytes < 0 )
+            return WIRE_MALFORMED;
+    }
+
+    if ( numbytes - offset < ( size_t ) field->numbytes )
+        return WIRE_TRUNCATED;
+
+    field->payload = bytes + offset;
+    field->headerlen = offset;
+    field->widthlen = offset - field->widthlen;
+    field->length = offset + field->numbytes;
+    return WIRE_OK;
+}
+
+WireStatus wire_messageSize ( size_t * size, FudgeMsg message )
+{
+    FudgeField * fields;
+    WireStatus status = WIRE_OK;
+    size_t numfields = FudgeMsg_numFields ( message ),
+           index,
+           payload;
+
+    *size = 0;
+    if ( ! numfields )
+        return WIRE_OK;
+
+    if ( ! ( fields = ( FudgeField * ) malloc ( sizeof ( FudgeField ) * numfields ) ) )
+        return WIRE_NO_MEMORY;
+    numfields = FudgeMsg_getFields ( fields, ( fudge_i32 ) numfields, message );
+
+    for ( index = 0; index < numfields; ++index )
+    {
+        const FudgeField * field = fields + index;
+
+        /* Prefix and type bytes, then the optional ordinal and name */
+        *size += 2;
+        if ( field->flags & FUDGE_FIELD_HAS_ORDINAL )
+            *size += 2;
+        if ( field->flags & FUDGE_FIELD_HAS_NAME )
+            *size += 1 + FudgeString_getSize ( field->name );
+
+        if ( wire_getFixedWidth ( field->type ) >= 0 )
+        {
+            *size += wire_getFixedWidth ( field->type );
+            continue;
+        }
+
+        switch ( field->type )
+        {
+            case FUDGE_TYPE_STRING:
+                payload = FudgeString_getSize ( field->data.string );
+                break;
+
+            case FUDGE_TYPE_FUDGE_MSG:
+                if ( ( status = wire_messageSize ( &payload,
+                                                   field->data.message ) ) != WIRE_OK )
+                    goto free_fields_and_return;
+                break;
+
+            /* Arrays, byte arrays and unknown types */
+            default:
+                payload = field->numbytes;
+                break;
+        }
+        *size += wire_getWidthSize ( payload ) + payload;
+    }
+
+free_fields_and_return:
+    free ( fields );
+    return status;
+}
+
+void wire_writeEnvelopeSize ( fudge_byte * header, fudge_i32 size )
+{
+    wire_writeI32 ( header + 4, size );
+}
+
+size_t wire_writeFieldHeader ( fudge_byte * target,
+                               const WireField * field,
+                               const fudge_byte * source,
+                               fudge_i32 numbytes )
+{
+    size_t idlen = field->headerlen - field->widthlen,
+           widthlen = wire_getWidthSize ( numbytes );
+    unsigned char prefix = ( unsigned char ) source [ 0 ] & ~WIRE_PREFIX_VAR_WIDTH_MASK;
+
+    memcpy ( target, source, idlen );
+
+    switch ( widthlen )
+    {
+        case 0:
+            break;
+        case 1:
+            prefix |= 0x20;
+            target [ idlen ] = ( fudge_byte ) numbytes;
+            break;
+        case 2:
+            prefix |= 0x40;
+            wire_writeI16 ( target + idlen, ( fudge_i16 ) numbytes );
+            break;
+        default:
+            prefix |= 0x60;
+            wire_writeI32 ( target + idlen, numbytes );
+            break;
+    }
+
+    target [ 0 ] = ( fudge_byte ) prefix;
+    return idlen + widthlen;
+}
+
@@ -0,0 +1,87 @@
+/**
+ * Copyright (C) 2012 - 2012, Vrai Stacey.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef INC_FUDGEPYC_WIRE_H
+#define INC_FUDGEPYC_WIRE_H
+
+#include <fudge/message.h>
+
+/* Readers for the raw Fudge wire format. These never touch Python objects
+ * and so may be called while the GIL is released. */
+
+/* Envelope header: directives, schema version, taxonomy and the size of
+ * the entire envelope (header included) */
+#define WIRE_HEADER_SIZE 8
+
+/* Largest possible field header: prefix, type, ordinal, name (with its
+ * length byte) and a four byte width */
+#define WIRE_MAX_FIELD_HEADER ( 2 + 2 + 1 + 255 + 4 )
+
+typedef enum
+{
+    WIRE_OK = 0,
+    WIRE_TRUNCATED,         /* Not enough bytes for the structure */
+    WIRE_MALFORMED,         /* Bytes are not valid Fudge encoding */
+    WIRE_NO_MEMORY          /* Failed to allocate working memory */
+} WireStatus;
+
+typedef struct
+{
+    fudge_byte directives;
+    fudge_byte schema;
+    fudge_i16 taxonomy;
+    fudge_i32 size;
+} WireHeader;
+
+typedef struct
+{
+    fudge_type_id type;
+    int hasordinal;
+    fudge_i16 ordinal;
+    const fudge_byte * name;    /* UTF8 name bytes, null if no name */
+    size_t namelen;
+    const fudge_byte * payload;
+    fudge_i32 numbytes;
+    size_t headerlen;           /* Bytes preceding the payload */
+    size_t widthlen;            /* Bytes of headerlen used by the width */
+    size_t length;              /* Total bytes, header and payload */
+} WireField;
+
+extern WireStatus wire_readHeader ( WireHeader * header,
+                                    const fudge_byte * bytes,
+                                    size_t numbytes );
+
+extern WireStatus wire_readField ( WireField * field,
+                                   const fudge_byte * bytes,
+                                   size_t numbytes );
+
+/* Overwrites the size held in an encoded envelope header */
+extern void wire_writeEnvelopeSize ( fudge_byte * header, fudge_i32 size );
+
+/* Writes the header of a variable width field, copying the prefix, type,
+ * ordinal and name from the existing encoding of field but with the width
+ * replaced by numbytes. Returns the number of bytes written, which will be
+ * no more than WIRE_MAX_FIELD_HEADER. */
+extern size_t wire_writeFieldHeader ( fudge_byte * target,
+                                      const WireField * field,
+                                      const fudge_byte * source,
+                                      fudge_i32 numbytes );
+
+/* Calculates the number of bytes the message's fields (and those of any
+ * sub-messages) occupy when encoded; this excludes the envelope header */
+extern WireStatus wire_messageSize ( size_t * size, FudgeMsg message );
+
+#endif
+
@@ -0,0 +1,64 @@
+# Copyright (C) 2012 - 2012, Vrai Stacey.
+#
+# Part of the Fudge-PyC distribution.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+# Times converting the Date, Time and DateTime fields of the dateTimes.dat
+# test payload to Python objects (decode) and building the same values
+# back in to a message (encode). Both directions use the datetime C-API
+# directly, so the cost per value should be close to that of creating the
+# datetime object itself.
+#
+# See INSTALL for how to run the benchmark scripts.
+
+import os, timeit
+import fudgepyc
+from fudgepyc import Envelope, Message
+
+DATAFILE = os.path.join ( os.path.dirname ( os.path.abspath ( __file__ ) ),
+                          'data', 'dateTimes.dat' )
+REPEATS = 5
+VALUES = 100000
+
+def decodeValues ( fields ):
+    for field in fields:
+        field.value ( )
+
+def encodeValues ( values ):
+    message = Message ( )
+    for value in values:
+        message.addField ( value )
+
+def timePerValue ( func, items ):
+    # Best of REPEATS, with each run converting at least VALUES values
+    loops = max ( 1, VALUES // len ( items ) )
+    best = min ( timeit.repeat ( lambda: func ( items ),
+                                 repeat = REPEATS,
+                                 number = loops ) )
+    return best / ( loops * len ( items ) ) * 1e9
+
+def main ( ):
+    fudgepyc.init ( )
+    with open ( DATAFILE, 'rb' ) as datafile:
+        message = Envelope.decode ( datafile.read ( ) ).message ( )
+
+    fields = message.getFields ( )
+    values = [ field.value ( ) for field in fields ]
+    print '%8s %16s %16s' % ( 'fields', 'ns/decode', 'ns/encode' )
+    print '%8d %16.1f %16.1f' % ( len ( fields ),
+                                  timePerValue ( decodeValues, fields ),
+                                  timePerValue ( encodeValues, values ) )
+
+if __name__ == '__main__':
+    main ( )
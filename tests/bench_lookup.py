@@ -0,0 +1,85 @@
+# Copyright (C) 2012 - 2012, Vrai Stacey.
+#
+# Part of the Fudge-PyC distribution.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+# Times looking up every field of a message by name and by ordinal, for a
+# range of message sizes. With the per-Message lookup index the time per
+# lookup should stay roughly flat as the number of fields grows.
+#
+# Also times building a message while looking up each field just after it
+# is added. Each add leaves the index stale, so this should be no slower
+# per field than the same build without an index (i.e. a linear search).
+#
+# See INSTALL for how to run the benchmark scripts.
+
+import timeit
+import fudgepyc
+from fudgepyc import Message
+
+SIZES = [ 4, 16, 64, 256, 500, 1024, 4096 ]
+REPEATS = 5
+
+def buildMessage ( size ):
+    message = Message ( )
+    for index in xrange ( size ):
+        message.addField ( index, 'field%d' % index, index )
+    return message
+
+def lookupNames ( message, names ):
+    for name in names:
+        message [ name ]
+
+def lookupOrdinals ( message, ordinals ):
+    for ordinal in ordinals:
+        message [ ordinal ]
+
+def buildInterleaved ( size ):
+    message = Message ( )
+    for index in xrange ( size ):
+        message.addField ( index, 'field%d' % index, index )
+        message [ 'field%d' % index ]
+    return message
+
+def timeLookups ( func, message, keys ):
+    # Best of REPEATS, with each run looking up at least 10000 keys
+    loops = max ( 1, 10000 // len ( keys ) )
+    best = min ( timeit.repeat ( lambda: func ( message, keys ),
+                                 repeat = REPEATS,
+                                 number = loops ) )
+    return best / ( loops * len ( keys ) ) * 1e9
+
+def timeInterleaved ( size ):
+    # Best of REPEATS, with each run adding at least 10000 fields
+    loops = max ( 1, 10000 // size )
+    best = min ( timeit.repeat ( lambda: buildInterleaved ( size ),
+                                 repeat = REPEATS,
+                                 number = loops ) )
+    return best / ( loops * size ) * 1e9
+
+def main ( ):
+    fudgepyc.init ( )
+    print '%8s %16s %16s %16s' % ( 'fields', 'ns/name lookup', 'ns/ord lookup',
+                                   'ns/add+lookup' )
+    for size in SIZES:
+        message = buildMessage ( size )
+        names = [ 'field%d' % index for index in xrange ( size ) ]
+        ordinals = range ( size )
+        print '%8d %16.1f %16.1f %16.1f' % ( size,
+                                             timeLookups ( lookupNames, message, names ),
+                                             timeLookups ( lookupOrdinals, message, ordinals ),
+                                             timeInterleaved ( size ) )
+
+if __name__ == '__main__':
+    main ( )
@@ -14,12 +14,12 @@
 # See the License for the specific language governing permissions and
 # limitations under the License.
 
-import datetime, os.path
+import datetime, os.path, threading
 from functools import partial
 from unittest import TestCase, TestSuite
 import fudgepyc
 import fudgepyc.types
-from fudgepyc import Envelope, Field, Message
+from fudgepyc import Envelope, Field, Message, StreamDecoder
 from fudgepyc.timezone import Timezone
 
 DATA_DIR = 'data'
@@ -298,6 +298,111 @@ class CodecTestCase ( TestCase ):
         self.assertEqual ( len ( nullmessage ), 0 )
 
 
+    def testDecodeMany ( self ):
+        names = [ 'ALLNAMES', 'SUBMSG', 'FIXEDWIDTH', 'UNKNOWN', 'DEEPERTREE' ]
+        references = [ self.__loadFile ( name ) for name in names ]
+        stream = ''.join ( references )
+
+        # Decode everything, including from behind a leading offset
+        for prefix in ( '', '----' ):
+            envelopes, consumed = Envelope.decodeMany ( prefix + stream, len ( prefix ) )
+            self.assertEqual ( consumed, len ( stream ) )
+            self.assertEqual ( len ( envelopes ), len ( references ) )
+            for envelope, reference in zip ( envelopes, references ):
+                expected = Envelope.decode ( reference ).message ( )
+                self.assertEqual ( str ( envelope.message ( ) ), str ( expected ) )
+
+        # Limit the number of envelopes and resume from the consumed offset
+        envelopes, consumed = Envelope.decodeMany ( stream, limit = 2 )
+        self.assertEqual ( len ( envelopes ), 2 )
+        self.assertEqual ( consumed, len ( references [ 0 ] ) + len ( references [ 1 ] ) )
+        envelopes, consumed = Envelope.decodeMany ( stream, consumed )
+        self.assertEqual ( len ( envelopes ), 3 )
+
+        # Incomplete trailing envelopes are left unconsumed
+        envelopes, consumed = Envelope.decodeMany ( stream [ : -1 ] )
+        self.assertEqual ( len ( envelopes ), 4 )
+        self.assertEqual ( consumed, len ( stream ) - len ( references [ -1 ] ) )
+        self.assertEqual ( Envelope.decodeMany ( '' ), ( [ ], 0 ) )
+
+        self.assertRaises ( IndexError, Envelope.decodeMany, stream, len ( stream ) + 1 )
+        self.assertRaises ( ValueError, Envelope.decodeMany, stream, 0, -1 )
+        self.assertRaises ( TypeError, Envelope.decodeMany, 123 )
+
+
+    def testDecodeParallel ( self ):
+        names = [ 'ALLNAMES', 'SUBMSG', 'FIXEDWIDTH', 'UNKNOWN', 'DEEPERTREE' ] * 20
+        references = [ self.__loadFile ( name ) for name in names ]
+        expected = [ str ( Envelope.decode ( reference ).message ( ) ) for reference in references ]
+
+        for threads in ( 1, 3, 8, 1000, 0 ):
+            envelopes = fudgepyc.decodeParallel ( references, threads = threads )
+            self.assertEqual ( [ str ( envelope.message ( ) ) for envelope in envelopes ], expected )
+
+        # Thread counts are capped, so the pool never holds more than 63
+        # workers alongside the Python threads
+        if os.path.isdir ( '/proc/self/task' ):
+            fudgepyc.decodeParallel ( references * 100, threads = 10000 )
+            self.assertTrue ( len ( os.listdir ( '/proc/self/task' ) ) <=
+                              63 + threading.active_count ( ) )
+
+        self.assertEqual ( fudgepyc.decodeParallel ( [ ] ), [ ] )
+        self.assertRaises ( fudgepyc.Exception, fudgepyc.decodeParallel, references + [ references [ 0 ] [ : 20 ] ] )
+        self.assertRaises ( TypeError, fudgepyc.decodeParallel, [ 123 ] )
+
+
+    def testDecodeSelected ( self ):
+        # Select by name, with unknown names ignored
+        reference = self.__loadFile ( 'ALLNAMES' )
+        message = Envelope.decode ( reference, fields = [ 'int', u'String', 'double array', 'missing' ] ).message ( )
+        self.assertEqual ( [ field.name ( ) for field in message.getFields ( ) ], [ 'int', 'String', 'double array' ] )
+        self.assertEqual ( message [ 'int' ].value ( ), 32772 )
+        self.assertEqual ( message [ 'double array' ].value ( ), [ 0.0 ] * 273 )
+
+        # Select by ordinal
+        reference = self.__loadFile ( 'ALLORDINALS' )
+        message = Envelope.decode ( reference, fields = set ( [ 7, 15 ] ) ).message ( )
+        self.assertEqual ( [ field.ordinal ( ) for field in message.getFields ( ) ], [ 7, 15 ] )
+        self.assertEqual ( message [ 15 ].value ( ), 'Kirk Wylie' )
+
+        # Select paths within sub-messages, alongside entire sub-messages
+        reference = self.__loadFile ( 'SUBMSG' )
+        message = Envelope.decode ( reference, fields = [ ( 'sub1', 827 ), 'sub2' ] ).message ( )
+        self.assertEqual ( len ( message ), 2 )
+        self.assertEqual ( len ( message [ 'sub1' ].value ( ) ), 1 )
+        self.assertEqual ( message [ 'sub1' ].value ( ) [ 827 ].value ( ), 'Blibble' )
+        self.assertEqual ( len ( message [ 'sub2' ].value ( ) ), 2 )
+
+        # A whole field selection takes precedence over a path
+        message = Envelope.decode ( reference, fields = [ ( 'sub1', 827 ), 'sub1' ] ).message ( )
+        self.assertEqual ( len ( message ), 1 )
+        self.assertEqual ( len ( message [ 'sub1' ].value ( ) ), 2 )
+
+        # Empty selections decode to empty messages; the original encoding
+        # should be unaffected by the selection
+        self.assertEqual ( len ( Envelope.decode ( reference, fields = [ ] ).message ( ) ), 0 )
+        self.assertEqual ( str ( Envelope.decode ( reference, fields = [ 'sub1', 'sub2' ] ).message ( ) ),
+                           str ( Envelope.decode ( reference ).message ( ) ) )
+
+        self.assertRaises ( TypeError, Envelope.decode, reference, fields = [ 1.5 ] )
+        self.assertRaises ( ValueError, Envelope.decode, reference, fields = [ ( ) ] )
+        self.assertRaises ( OverflowError, Envelope.decode, reference, fields = [ 100000 ] )
+        self.assertRaises ( OverflowError, Envelope.decode, reference, fields = [ -1 ] )
+
+        # Paths through a sub-message's ordinal and its name are combined
+        submsg = Message ( )
+        submsg.addField ( 1, 'a' )
+        submsg.addField ( 2, 'b' )
+        submsg.addField ( 3, 'c' )
+        message = Message ( )
+        message.addField ( submsg, 'sub', 5 )
+        reference = Envelope ( message ).encode ( )
+        message = Envelope.decode ( reference, fields = [ ( 'sub', 'a' ), ( 5, 'c' ) ] ).message ( )
+        self.assertEqual ( [ field.name ( ) for field in message [ 'sub' ].value ( ).getFields ( ) ], [ 'a', 'c' ] )
+        message = Envelope.decode ( reference, fields = [ ( 5, 'b' ), 'sub' ] ).message ( )
+        self.assertEqual ( len ( message [ 'sub' ].value ( ) ), 3 )
+
+
     def testEncodeAllNames ( self ):
         # Construct the message
         message1 = Message ( )
@@ -510,6 +615,273 @@ class CodecTestCase ( TestCase ):
         self.assertEqual ( encoded, reference )
 
 
+    def testEncodeInto ( self ):
+        reference = self.__loadFile ( 'SUBMSG' )
+        envelope = Envelope.decode ( reference )
+
+        # Encode in to a buffer of exactly the right size
+        target = bytearray ( len ( reference ) )
+        self.assertEqual ( envelope.encodeInto ( target ), len ( reference ) )
+        self.assertEqual ( str ( target ), reference )
+
+        # Encode at an offset, leaving the leading bytes untouched
+        target = bytearray ( '-' * ( len ( reference ) + 4 ) )
+        self.assertEqual ( envelope.encodeInto ( target, 4 ), len ( reference ) )
+        self.assertEqual ( str ( target [ : 4 ] ), '----' )
+        self.assertEqual ( str ( target [ 4 : ] ), reference )
+
+        # Buffers that are too small, invalid offsets and read-only buffers
+        # should all fail
+        self.assertRaises ( ValueError, envelope.encodeInto, bytearray ( len ( reference ) - 1 ) )
+        self.assertRaises ( ValueError, envelope.encodeInto, bytearray ( len ( reference ) ), 1 )
+        self.assertRaises ( IndexError, envelope.encodeInto, bytearray ( len ( reference ) ), -1 )
+        self.assertRaises ( TypeError, envelope.encodeInto, reference )
+
+
+    def testStreamDecoder ( self ):
+        names = [ 'ALLNAMES', 'SUBMSG', 'FIXEDWIDTH', 'VARIABLEWIDTH', 'DATETIMES' ]
+        references = [ self.__loadFile ( name ) for name in names ]
+        stream = ''.join ( references )
+
+        # Nothing to decode until a complete envelope has arrived
+        decoder = StreamDecoder ( )
+        self.assertEqual ( list ( decoder ), [ ] )
+        decoder.feed ( stream [ : 7 ] )
+        self.assertEqual ( list ( decoder ), [ ] )
+        self.assertEqual ( decoder.pending ( ), 7 )
+
+        # Feed the remainder in awkwardly sized chunks, collecting envelopes
+        # as they complete
+        decoded = [ ]
+        for start in range ( 7, len ( stream ), 333 ):
+            decoder.feed ( stream [ start : start + 333 ] )
+            decoded.extend ( decoder )
+        self.assertEqual ( decoder.pending ( ), 0 )
+        self.assertEqual ( len ( decoded ), len ( references ) )
+        for envelope, reference in zip ( decoded, references ):
+            expected = Envelope.decode ( reference ).message ( )
+            self.assertEqual ( str ( envelope.message ( ) ), str ( expected ) )
+
+        # A single chunk holding everything yields every envelope at once
+        decoder = StreamDecoder ( )
+        decoder.feed ( stream + references [ 0 ] [ : 10 ] )
+        self.assertEqual ( len ( list ( decoder ) ), len ( references ) )
+        self.assertEqual ( decoder.pending ( ), 10 )
+
+        self.assertRaises ( TypeError, decoder.feed, 123 )
+
+        # An invalid header discards the buffered bytes, so decoding can
+        # resume with the next chunk rather than failing forever
+        decoder = StreamDecoder ( )
+        decoder.feed ( '\x00\x00\x00\x00\x00\x00\x00\x02' + references [ 0 ] )
+        self.assertRaises ( fudgepyc.Exception, list, decoder )
+        self.assertEqual ( decoder.pending ( ), 0 )
+        self.assertEqual ( list ( decoder ), [ ] )
+        decoder.feed ( references [ 1 ] )
+        decoded = list ( decoder )
+        self.assertEqual ( len ( decoded ), 1 )
+        self.assertEqual ( str ( decoded [ 0 ].message ( ) ),
+                           str ( Envelope.decode ( references [ 1 ] ).message ( ) ) )
+
+
+    def testLoads ( self ):
+        # Should match converting the decoded Fields by hand
+        for name in DATA_FILES.iterkeys ( ):
+            reference = self.__loadFile ( name )
+            expected = self.__messageToDict ( Envelope.decode ( reference ).message ( ) )
+            self.assertEqual ( fudgepyc.loads ( reference ), expected )
+            self.assertEqual ( fudgepyc.loads ( buffer ( reference ) ), expected )
+
+        submsg = Message ( )
+        submsg.addField ( 1, 'x' )
+        submsg.addField ( 2, 'x' )
+        message = Message ( )
+        message.addField ( u'one', 'name' )
+        message.addFieldI32Array ( [ 1, 2 ], 'array' )
+        message.addFieldI32Array ( [ 3 ], 'array' )
+        message.addFieldI32Array ( [ 4 ], 'array' )
+        message.addField ( 1.5, ordinal = 7 )
+        message.addField ( 'two', 'name', 8 )
+        message.addField ( submsg, 'sub' )
+        message.addField ( True )
+        encoded = Envelope ( message ).encode ( )
+
+        self.assertEqual ( fudgepyc.loads ( encoded ),
+                           { u'name'  : [ u'one', u'two' ],
+                             u'array' : [ [ 1, 2 ], [ 3 ], [ 4 ] ],
+                             7        : 1.5,
+                             u'sub'   : { u'x' : [ 1, 2 ] },
+                             None     : True } )
+        self.assertEqual ( fudgepyc.loads ( encoded, repeated = 'first', ordinals = 'str' ),
+                           { u'name'  : u'one',
+                             u'array' : [ 1, 2 ],
+                             '7'      : 1.5,
+                             u'sub'   : { u'x' : 1 },
+                             None     : True } )
+        self.assertEqual ( fudgepyc.loads ( encoded, 'last', 'ignore' ),
+                           { u'name'  : u'two',
+                             u'array' : [ 4 ],
+                             u'sub'   : { u'x' : 2 },
+                             None     : True } )
+
+        self.assertRaises ( ValueError, fudgepyc.loads, encoded, repeated = 'error' )
+        self.assertRaises ( ValueError, fudgepyc.loads, encoded, repeated = 'unknown' )
+        self.assertRaises ( ValueError, fudgepyc.loads, encoded, ordinals = 'unknown' )
+        self.assertRaises ( TypeError, fudgepyc.loads, 123 )
+
+
+    def __messageToDict ( self, message ):
+        target, repeated = { }, set ( )
+        for field in message.getFields ( ):
+            key = field.name ( )
+            if key is None:
+                key = field.ordinal ( )
+            value = field.value ( )
+            if isinstance ( value, Message ):
+                value = self.__messageToDict ( value )
+
+            if key not in target:
+                target [ key ] = value
+            elif key in repeated:
+                target [ key ].append ( value )
+            else:
+                target [ key ] = [ target [ key ], value ]
+                repeated.add ( key )
+        return target
+
+
+    def testDumps ( self ):
+        submsg = Message ( )
+        submsg.addField ( 1 )
+        obj = { 'name'    : u'one',
+                u'ints'   : [ 1, 2L, 3 ],
+                'floats'  : ( 1.5, 2.5 ),
+                'empty'   : [ ],
+                'strings' : [ 'a', 'b', 'c' ],
+                'mixed'   : [ 1, 2.5, None ],
+                'numbers' : [ 1, 2.5, 3L ],
+                'single'  : [ 'x' ],
+                'sub'     : { 'x' : True, 2 : { } },
+                'msg'     : submsg,
+                'date'    : datetime.date ( 2012, 3, 4 ),
+                7         : 1.25,
+                None      : 'anonymous' }
+        encoded = fudgepyc.dumps ( obj )
+        message = Envelope.decode ( encoded ).message ( )
+        self.assertEqual ( len ( message ), 17 )
+        self.assertEqual ( message [ 'name' ].type ( ), fudgepyc.types.STRING )
+        self.assertEqual ( message [ 'ints' ].type ( ), fudgepyc.types.LONG_ARRAY )
+        self.assertEqual ( message [ 'floats' ].type ( ), fudgepyc.types.DOUBLE_ARRAY )
+        self.assertEqual ( message [ 'empty' ].type ( ), fudgepyc.types.LONG_ARRAY )
+        self.assertEqual ( message [ 'numbers' ].type ( ), fudgepyc.types.DOUBLE_ARRAY )
+        self.assertEqual ( message [ 7 ].value ( ), 1.25 )
+        self.assertEqual ( message [ 'msg' ].value ( ).getFieldAtIndex ( 0 ).value ( ), 1 )
+
+        self.assertEqual ( fudgepyc.loads ( encoded ),
+                           { u'name'    : u'one',
+                             u'ints'    : [ 1, 2, 3 ],
+                             u'floats'  : [ 1.5, 2.5 ],
+                             u'empty'   : [ ],
+                             u'strings' : [ u'a', u'b', u'c' ],
+                             u'mixed'   : [ 1, 2.5, None ],
+                             u'numbers' : [ 1.0, 2.5, 3.0 ],
+                             u'single'  : u'x',
+                             u'sub'     : { u'x' : True, 2 : { } },
+                             u'msg'     : { None : 1 },
+                             u'date'    : datetime.date ( 2012, 3, 4 ),
+                             7          : 1.25,
+                             None       : u'anonymous' } )
+
+        # Header values
+        envelope = Envelope.decode ( fudgepyc.dumps ( { }, 3, taxonomy = 1234 ) )
+        self.assertEqual ( ( envelope.schema ( ), envelope.taxonomy ( ) ), ( 3, 1234 ) )
+        self.assertEqual ( len ( envelope.message ( ) ), 0 )
+
+        cyclic = { }
+        cyclic [ 'self' ] = cyclic
+        self.assertRaises ( RuntimeError, fudgepyc.dumps, cyclic )
+        self.assertRaises ( TypeError, fudgepyc.dumps, [ 1, 2, 3 ] )
+        self.assertRaises ( TypeError, fudgepyc.dumps, { 1.5 : 1 } )
+        self.assertRaises ( TypeError, fudgepyc.dumps, { 'x' : object ( ) } )
+        self.assertRaises ( OverflowError, fudgepyc.dumps, { -1 : 1 } )
+
+
+    def testCopyDecoded ( self ):
+        for name in DATA_FILES.iterkeys ( ):
+            reference = self.__loadFile ( name )
+            message = Envelope.decode ( reference ).message ( )
+            for deep in ( True, False ):
+                duplicate = message.copy ( deep )
+                self.assertEqual ( str ( duplicate ), str ( message ) )
+                self.assertEqual ( Envelope ( duplicate ).encode ( ),
+                                   Envelope ( message ).encode ( ) )
+
+
+    def testEncodeMany ( self ):
+        names = [ 'ALLNAMES', 'SUBMSG', 'FIXEDWIDTH', 'UNKNOWN', 'DEEPERTREE' ]
+        envelopes = [ Envelope.decode ( self.__loadFile ( name ) ) for name in names ]
+        reference = ''.join ( envelope.encode ( ) for envelope in envelopes )
+
+        self.assertEqual ( Envelope.encodeMany ( envelopes ), reference )
+        self.assertEqual ( Envelope.encodeMany ( tuple ( envelopes ) ), reference )
+        self.assertEqual ( Envelope.encodeMany ( [ ] ), '' )
+
+        # Encode in to a buffer at an offset, leaving the leading bytes untouched
+        target = bytearray ( '-' * ( len ( reference ) + 4 ) )
+        self.assertEqual ( Envelope.encodeManyInto ( envelopes, target, 4 ), len ( reference ) )
+        self.assertEqual ( str ( target [ : 4 ] ), '----' )
+        self.assertEqual ( str ( target [ 4 : ] ), reference )
+
+        # Nothing is written if the batch doesn't fit
+        target = bytearray ( '-' * ( len ( reference ) - 1 ) )
+        self.assertRaises ( ValueError, Envelope.encodeManyInto, envelopes, target )
+        self.assertEqual ( str ( target ), '-' * ( len ( reference ) - 1 ) )
+
+        self.assertRaises ( TypeError, Envelope.encodeMany, envelopes + [ 'not an envelope' ] )
+        self.assertRaises ( TypeError, Envelope.encodeMany, 123 )
+        self.assertRaises ( TypeError, Envelope.encodeManyInto, envelopes, reference )
+
+
+    def testEncodedSize ( self ):
+        for name in DATA_FILES.iterkeys ( ):
+            envelope = Envelope.decode ( self.__loadFile ( name ) )
+            encoded = envelope.encode ( )
+            self.assertEqual ( envelope.encodedSize ( ), len ( encoded ) )
+            self.assertEqual ( envelope.message ( ).encodedSize ( ), len ( encoded ) - 8 )
+
+        # Check width prefixes either side of each boundary
+        for size in ( 0, 1, 255, 256, 32767, 32768, 100000 ):
+            message = Message ( )
+            message.addFieldByteArray ( 'x' * size, 'bytes' )
+            message.addField ( u'x' * size, ordinal = 1 )
+            submessage = Message ( )
+            submessage.addFieldI32Array ( [ 1 ] * ( size / 4 ) )
+            message.addField ( submessage, 'sub', 2 )
+            envelope = Envelope ( message )
+            self.assertEqual ( envelope.encodedSize ( ), len ( envelope.encode ( ) ) )
+
+        self.assertEqual ( Message ( ).encodedSize ( ), 0 )
+        self.assertEqual ( Envelope ( Message ( ) ).encodedSize ( ), 8 )
+
+
+    def testPeekHeader ( self ):
+        for name in DATA_FILES.iterkeys ( ):
+            reference = self.__loadFile ( name )
+            envelope = Envelope.decode ( reference )
+            self.assertEqual ( Envelope.peekHeader ( reference ),
+                               ( envelope.directives ( ), envelope.schema ( ), envelope.taxonomy ( ), len ( reference ) ) )
+
+        # Header values set on encoding, read from behind an offset
+        encoded = '----' + Envelope ( Message ( ), 1, 2, 1234 ).encode ( )
+        self.assertEqual ( Envelope.peekHeader ( encoded, 4 ), ( 1, 2, 1234, 8 ) )
+        self.assertEqual ( Envelope.peekHeader ( encoded [ : 12 ], offset = 4 ), ( 1, 2, 1234, 8 ) )
+
+        self.assertRaises ( fudgepyc.Exception, Envelope.peekHeader, encoded, 5 )
+        self.assertRaises ( fudgepyc.Exception, Envelope.peekHeader, '\x00' * 8 )
+        self.assertRaises ( IndexError, Envelope.peekHeader, encoded, 13 )
+        self.assertRaises ( TypeError, Envelope.peekHeader, 123 )
+
+
     def __loadFile ( self, name ):
         infile = open ( self.__datafiles [ name ], 'rb' )
         try:
@@ -541,11 +913,22 @@ def suite ( ):
               'testDecodeVariableWidths',
               'testDecodeDateTimes',
               'testDecodeDeepTree',
+              'testDecodeMany',
+              'testDecodeParallel',
+              'testDecodeSelected',
               'testEncodeAllNames',
               'testEncodeAllOrdinals',
               'testEncodeFixedWidths',
               'testEncodeSubMsgs',
               'testEncodeVariableWidths',
               'testEncodeDateTimes',
-              'testEncodeDeepTree' ]
+              'testEncodeDeepTree',
+              'testEncodeInto',
+              'testEncodeMany',
+              'testEncodedSize',
+              'testPeekHeader',
+              'testLoads',
+              'testDumps',
+              'testCopyDecoded',
+              'testStreamDecoder' ]
     return TestSuite ( map ( CodecTestCase, tests ) )
@@ -14,10 +14,10 @@
 # See the License for the specific language governing permissions and
 # limitations under the License.
 
-import datetime, unittest
+import array, copy, datetime, pickle, unittest
 import fudgepyc
 import fudgepyc.types
-from fudgepyc import Field, Message
+from fudgepyc import Field, Message, MessageTemplate
 
 class TestTimeZone ( datetime.tzinfo ):
     def utcoffset ( self, dt ): return datetime.timedelta ( minutes = -300 )
@@ -526,6 +526,625 @@ class MessageTestCase ( unittest.TestCase ):
         self.assertEquals ( message1 [ 'long_fromfloat' ].value ( ),  9220000000000000000 )
 
 
+    def testAddFields ( self ):
+        submessage = Message ( )
+        message1 = Message ( )
+        message1.addFields ( [ ( True, ),
+                               ( 'a string', 'string' ),
+                               ( 12345, None, 2 ),
+                               ( 1.5, 'float', 3, fudgepyc.types.FLOAT ),
+                               ( submessage, 'sub' ),
+                               { 'value' : [ 1, 2, 3 ], 'name' : 'ints', 'type' : fudgepyc.types.INT_ARRAY },
+                               { 'value' : None, 'ordinal' : 4 } ] )
+
+        # Should be identical to adding each field in turn
+        message2 = Message ( )
+        message2.addField ( True )
+        message2.addField ( 'a string', 'string' )
+        message2.addField ( 12345, ordinal = 2 )
+        message2.addField ( 1.5, 'float', 3, fudgepyc.types.FLOAT )
+        message2.addField ( submessage, 'sub' )
+        message2.addField ( [ 1, 2, 3 ], 'ints', type = fudgepyc.types.INT_ARRAY )
+        message2.addField ( None, ordinal = 4 )
+
+        self.assertEqual ( len ( message1 ), 7 )
+        self.assertEqual ( str ( message1 ), str ( message2 ) )
+        self.assertEqual ( message1 [ 'float' ].type ( ), fudgepyc.types.FLOAT )
+        self.assertEqual ( message1 [ 'ints' ].value ( ), [ 1, 2, 3 ] )
+
+        # Any iterable is accepted
+        message1 = Message ( )
+        message1.addFields ( ( value, str ( value ) ) for value in range ( 10 ) )
+        self.assertEqual ( len ( message1 ), 10 )
+        self.assertEqual ( message1 [ '9' ].value ( ), 9 )
+
+        # Fields before a bad field remain
+        message1 = Message ( )
+        self.assertRaises ( TypeError, message1.addFields, [ ( 1, ), 'bad' ] )
+        self.assertEqual ( len ( message1 ), 1 )
+        self.assertRaises ( TypeError, message1.addFields, [ ( ) ] )
+        self.assertRaises ( TypeError, message1.addFields, [ { 'name' : 'novalue' } ] )
+        self.assertRaises ( TypeError, message1.addFields, [ ( 1, 'name', 'ordinal' ) ] )
+        self.assertRaises ( TypeError, message1.addFields, [ ( object ( ), ) ] )
+        self.assertRaises ( OverflowError, message1.addFields, [ ( 1, None, 100000 ) ] )
+        self.assertRaises ( TypeError, message1.addFields, 123 )
+        self.assertEqual ( len ( message1 ), 1 )
+
+
+    def testNameCache ( self ):
+        fudgepyc.clearNameCache ( )
+        stats = fudgepyc.nameCacheStats ( )
+        self.assertEqual ( ( stats [ 'hits' ], stats [ 'misses' ], stats [ 'size' ] ), ( 0, 0, 0 ) )
+        self.assertTrue ( stats [ 'capacity' ] > 0 )
+
+        # First use of a name misses, subsequent uses (by add or lookup) hit
+        message1 = Message ( )
+        message1.addField ( 1, 'cached' )
+        message1.addFieldI32 ( 2, 'cached' )
+        self.assertEqual ( message1 [ 'cached' ].value ( ), 1 )
+        self.assertEqual ( message1.getFieldByName ( 'cached' ).value ( ), 1 )
+        message1.addField ( 3, u'cached\u2019' )
+        self.assertEqual ( message1 [ u'cached\u2019' ].value ( ), 3 )
+
+        stats = fudgepyc.nameCacheStats ( )
+        self.assertEqual ( stats [ 'misses' ], 2 )
+        self.assertEqual ( stats [ 'hits' ], 4 )
+        self.assertEqual ( stats [ 'size' ], 2 )
+
+        # Names stay correct once many more names than slots have been used
+        message1 = Message ( )
+        names = [ 'field%d' % idx for idx in range ( stats [ 'capacity' ] * 2 ) ]
+        for idx, name in enumerate ( names ):
+            message1.addField ( idx, name )
+        for idx, name in enumerate ( names ):
+            self.assertEqual ( message1 [ name ].value ( ), idx )
+        stats = fudgepyc.nameCacheStats ( )
+        self.assertTrue ( stats [ 'evictions' ] > 0 )
+        self.assertTrue ( stats [ 'size' ] <= stats [ 'capacity' ] )
+
+        fudgepyc.clearNameCache ( )
+        self.assertEqual ( fudgepyc.nameCacheStats ( ) [ 'size' ], 0 )
+        self.assertEqual ( message1 [ 'field0' ].name ( ), 'field0' )
+
+
+    def testMessageTemplate ( self ):
+        template = MessageTemplate ( [ ( 'bid',    None, fudgepyc.types.DOUBLE ),
+                                       ( 'ask',    None, fudgepyc.types.FLOAT ),
+                                       ( None,     1,    fudgepyc.types.STRING ),
+                                       ( u'size',  2,    fudgepyc.types.INT ),
+                                       ( 'levels', None, fudgepyc.types.INT_ARRAY ),
+                                       ( 'flag',   None, fudgepyc.types.INDICATOR ),
+                                       ( 'date',   None, fudgepyc.types.DATE ) ] )
+        self.assertEqual ( len ( template ), 7 )
+
+        values = ( 1.25, 1.5, 'GBPUSD', 1000, [ 1, 2, 3 ], None, datetime.date ( 2012, 3, 4 ) )
+        message1 = template.build ( values )
+
+        # Should be identical to adding each field in turn
+        message2 = Message ( )
+        message2.addFieldF64 ( 1.25, 'bid' )
+        message2.addFieldF32 ( 1.5, 'ask' )
+        message2.addFieldString ( 'GBPUSD', ordinal = 1 )
+        message2.addFieldI32 ( 1000, 'size', 2 )
+        message2.addFieldI32Array ( [ 1, 2, 3 ], 'levels' )
+        message2.addFieldIndicator ( 'flag' )
+        message2.addFieldDate ( datetime.date ( 2012, 3, 4 ), 'date' )
+        self.assertEqual ( str ( message1 ), str ( message2 ) )
+        self.assertEqual ( message1 [ 'ask' ].type ( ), fudgepyc.types.FLOAT )
+
+        # Each build creates a new message
+        message3 = template.build ( [ 2.5, 3.5, 'EURUSD', 10, [ ], None, datetime.date ( 2012, 3, 5 ) ] )
+        self.assertEqual ( message3 [ 'bid' ].value ( ), 2.5 )
+        self.assertEqual ( message1 [ 'bid' ].value ( ), 1.25 )
+
+        # None omits non-indicator fields
+        message3 = template.build ( ( 1.25, None, None, None, None, None, None ) )
+        self.assertEqual ( [ field.name ( ) for field in message3.getFields ( ) ], [ 'bid', 'flag' ] )
+
+        # Encoding matches encoding the built message
+        self.assertEqual ( template.encode ( values ), fudgepyc.Envelope ( message2 ).encode ( ) )
+        self.assertEqual ( template.encode ( values, 1, 2, 3 ), fudgepyc.Envelope ( message2, 1, 2, 3 ).encode ( ) )
+
+        self.assertRaises ( ValueError, template.build, values [ : -1 ] )
+        self.assertRaises ( ValueError, template.build, ( 'x', ) + values [ 1 : ] )
+        self.assertRaises ( TypeError, MessageTemplate, [ ( 'bad type', None, 16 ) ] )
+        self.assertRaises ( TypeError, MessageTemplate, [ ( 123, None, fudgepyc.types.INT ) ] )
+        self.assertRaises ( OverflowError, MessageTemplate, [ ( None, -1, fudgepyc.types.INT ) ] )
+        self.assertRaises ( TypeError, MessageTemplate, [ ( 'short', ) ] )
+
+
+    def testIteration ( self ):
+        submsg = Message ( )
+        submsg.addField ( 1, 'x' )
+        message = Message ( )
+        self.assertEqual ( list ( message ), [ ] )
+        self.assertEqual ( list ( message.iterValues ( ) ), [ ] )
+
+        message.addField ( True, 'bool' )
+        message.addFieldI32 ( 123, ordinal = 4 )
+        message.addField ( u'string', 'str', 5 )
+        message.addFieldI16Array ( [ 1, 2, 3 ] )
+        message.addField ( submsg, 'sub' )
+        message.addFieldIndicator ( 'none' )
+
+        fields = message.getFields ( )
+        self.assertEqual ( [ str ( field ) for field in message ],
+                           [ str ( field ) for field in fields ] )
+        self.assertEqual ( [ field.name ( ) for field in message ],
+                           [ 'bool', None, 'str', None, 'sub', 'none' ] )
+        self.assertEqual ( list ( message.iterValues ( ) ),
+                           [ field.value ( ) for field in fields ] )
+
+        # Sub-messages are the same objects as returned by Field.value
+        values = list ( message.iterValues ( ) )
+        self.assertTrue ( values [ 4 ] is submsg )
+
+        # Stopping early, and adding fields while iterating
+        iterator = iter ( message )
+        self.assertEqual ( iterator.next ( ).value ( ), True )
+        message.addField ( 1.5, 'late' )
+        self.assertEqual ( len ( list ( iterator ) ), 5 )
+        self.assertEqual ( len ( list ( message ) ), 7 )
+        self.assertEqual ( list ( message.iterValues ( ) ) [ -1 ], 1.5 )
+
+
+    def testIndexedLookup ( self ):
+        # Large enough for lookups to use the index
+        message = Message ( )
+        for index in range ( 100 ):
+            message.addField ( index, 'field%d' % index, index * 2 )
+        message.addField ( 'repeat', 'field5', 1 )
+
+        for index in range ( 100 ):
+            self.assertEqual ( message [ 'field%d' % index ].value ( ), index )
+            self.assertEqual ( message [ u'field%d' % index ].ordinal ( ), index * 2 )
+            self.assertEqual ( message [ index * 2 ].name ( ), 'field%d' % index )
+            self.assertEqual ( message.getFieldByName ( 'field%d' % index ).value ( ), index )
+            self.assertEqual ( message.getFieldByOrdinal ( index * 2 ).value ( ), index )
+
+        # First field with a name/ordinal wins
+        self.assertEqual ( message [ 'field5' ].value ( ), 5 )
+        self.assertEqual ( message [ 1 ].value ( ), 'repeat' )
+
+        self.assertRaises ( LookupError, message.__getitem__, 'missing' )
+        self.assertRaises ( LookupError, message.__getitem__, 3 )
+        self.assertEqual ( message.getFieldByName ( 'missing' ), None )
+        self.assertEqual ( message.getFieldByOrdinal ( 3 ), None )
+        self.assertEqual ( message.getFieldByOrdinal ( 65535 ), None )
+
+        # Adding fields invalidates the index
+        message.addField ( 'added', 'missing', 3 )
+        self.assertEqual ( message [ 'missing' ].value ( ), 'added' )
+        self.assertEqual ( message [ 3 ].value ( ), 'added' )
+
+        # Sparse ordinals fall back to searching the message
+        message.addField ( 'sparse', ordinal = 32767 )
+        self.assertEqual ( message [ 32767 ].value ( ), 'sparse' )
+        self.assertEqual ( message [ 0 ].value ( ), 0 )
+
+
+    def testGetAll ( self ):
+        message = Message ( )
+        message.addFieldF64 ( 1.5, 'price', 1 )
+        message.addFieldI32 ( 100, 'size', 2 )
+        message.addFieldF64 ( 1.75, 'price', 1 )
+        message.addFieldI32 ( 200, 'size', 2 )
+        message.addFieldF64 ( 2.0, 'price' )
+        message.addField ( u'text', 'note', 1 )
+
+        fields = message.getAll ( 'price' )
+        self.assertEqual ( [ field.value ( ) for field in fields ], [ 1.5, 1.75, 2.0 ] )
+        self.assertEqual ( [ field.value ( ) for field in message.getAll ( 1 ) ],
+                           [ 1.5, 1.75, u'text' ] )
+        self.assertEqual ( message.getAll ( 'missing' ), [ ] )
+        self.assertEqual ( message.getAll ( key = 5 ), [ ] )
+
+        self.assertEqual ( message.getAllValues ( u'price' ), [ 1.5, 1.75, 2.0 ] )
+        self.assertEqual ( message.getAllValues ( 2 ), [ 100, 200 ] )
+        self.assertEqual ( message.getAllValues ( 'missing', typed = True ), [ ] )
+
+        # Typed arrays only when every match has the same numeric type
+        values = message.getAllValues ( 'price', typed = True )
+        self.assertTrue ( isinstance ( values, array.array ) )
+        self.assertEqual ( values.typecode, 'd' )
+        self.assertEqual ( values.tolist ( ), [ 1.5, 1.75, 2.0 ] )
+        # Integers are widened, as Fudge-C downcasts them (100 is held as a Byte)
+        values = message.getAllValues ( 'size', True )
+        self.assertEqual ( values.typecode, 'h' )
+        self.assertEqual ( values.tolist ( ), [ 100, 200 ] )
+        message.addFieldF32 ( 3.5, 'price' )
+        self.assertEqual ( message.getAllValues ( 'price', typed = True ).tolist ( ), [ 1.5, 1.75, 2.0, 3.5 ] )
+        message.addFieldI32 ( 100000, 'price' )
+        self.assertEqual ( message.getAllValues ( 'price', typed = True ), [ 1.5, 1.75, 2.0, 3.5, 100000 ] )
+        self.assertEqual ( message.getAllValues ( 1, typed = True ), [ 1.5, 1.75, u'text' ] )
+
+        # Sub-messages are the same objects as returned by Field.value
+        submsg = Message ( )
+        message.addField ( submsg, 'sub' )
+        self.assertTrue ( message.getAllValues ( 'sub' ) [ 0 ] is submsg )
+
+        # Large enough to use the lookup index
+        for index in range ( 20 ):
+            message.addFieldI16 ( index, 'short' )
+        values = message.getAllValues ( 'short', typed = True )
+        self.assertEqual ( values.typecode, 'b' )
+        self.assertEqual ( values.tolist ( ), range ( 20 ) )
+        self.assertEqual ( len ( message.getAll ( 'price' ) ), 5 )
+
+        self.assertRaises ( ValueError, message.getAll, 1.5 )
+        self.assertRaises ( OverflowError, message.getAllValues, -1 )
+
+
+    def testCopy ( self ):
+        submsg = Message ( )
+        submsg.addField ( 1, 'x' )
+        message = Message ( )
+        message.addField ( True, 'bool', 1 )
+        message.addFieldI16 ( 256, ordinal = 2 )
+        message.addField ( u'string', 'str' )
+        message.addFieldF32Array ( [ 1.5, 2.5 ], 'floats' )
+        message.addFieldByteArray ( 'bytes', 'bytes' )
+        message.addField16ByteArray ( 'x' * 16, 'fixed' )
+        message.addField ( datetime.datetime ( 2012, 3, 4, 5, 6, 7 ), 'datetime' )
+        message.addField ( submsg, 'sub' )
+        message.addFieldIndicator ( )
+
+        for duplicate in ( message.copy ( ),
+                           message.copy ( deep = False ),
+                           copy.copy ( message ),
+                           copy.deepcopy ( message ) ):
+            self.assertEqual ( str ( duplicate ), str ( message ) )
+            self.assertEqual ( [ field.type ( ) for field in duplicate ],
+                               [ field.type ( ) for field in message ] )
+
+            # Copies are independent of the original
+            duplicate.addField ( 'extra', 'extra' )
+            self.assertEqual ( len ( duplicate ), len ( message ) + 1 )
+
+        # Deep copies have their own sub-messages
+        duplicate = message.copy ( )
+        self.assertFalse ( duplicate [ 'sub' ].value ( ) is submsg )
+        duplicate [ 'sub' ].value ( ).addField ( 2, 'y' )
+        self.assertEqual ( len ( submsg ), 1 )
+        duplicate = copy.deepcopy ( message )
+        self.assertFalse ( duplicate [ 'sub' ].value ( ) is submsg )
+
+        # Shallow copies share them, including the Python objects
+        duplicate = copy.copy ( message )
+        self.assertTrue ( duplicate [ 'sub' ].value ( ) is submsg )
+        duplicate [ 'sub' ].value ( ).addField ( 2, 'y' )
+        self.assertEqual ( len ( submsg ), 2 )
+
+        # A sub-message held twice is copied once, and the copy is memoised
+        message = Message ( )
+        message.addField ( submsg, 'a' )
+        message.addField ( submsg, 'b' )
+        memo = { }
+        duplicate = copy.deepcopy ( message, memo )
+        duplicate [ 'a' ].value ( ).addField ( 3, 'z' )
+        self.assertEqual ( len ( duplicate [ 'b' ].value ( ) ), 3 )
+        self.assertEqual ( len ( submsg ), 2 )
+        self.assertTrue ( message.__deepcopy__ ( memo ) is duplicate )
+
+        # Subclasses with their own __new__ can be copied
+        class Derived ( Message ):
+            def __new__ ( cls, *args ):
+                return Message.__new__ ( cls, *args )
+        derived = Derived ( )
+        derived.addField ( 1, 'x' )
+        for duplicate in ( copy.copy ( derived ), copy.deepcopy ( derived ) ):
+            self.assertTrue ( type ( duplicate ) is Derived )
+            self.assertEqual ( duplicate, derived )
+
+        self.assertEqual ( len ( Message ( ).copy ( ) ), 0 )
+
+
+    def testEquality ( self ):
+        def build ( extra = None ):
+            submsg = Message ( )
+            submsg.addField ( 1, 'x' )
+            message = Message ( )
+            message.addField ( True, 'bool', 1 )
+            message.addField ( u'string', 'str' )
+            message.addFieldF64 ( -0.0, 'zero' )
+            message.addFieldI32Array ( [ 1, 2, 3 ], 'ints' )
+            message.addField ( datetime.datetime ( 2012, 3, 4, 5, 6, 7 ), 'datetime' )
+            message.addField ( submsg, 'sub' )
+            if extra is not None:
+                submsg.addField ( extra, 'extra' )
+            return message
+
+        x, y = build ( ), build ( )
+        self.assertTrue ( x == y )
+        self.assertFalse ( x != y )
+        self.assertTrue ( x == x.copy ( ) )
+        self.assertEqual ( x.contentHash ( ), y.contentHash ( ) )
+        self.assertEqual ( x, fudgepyc.Envelope.decode (
+                               fudgepyc.Envelope ( x ).encode ( ) ).message ( ) )
+
+        # Any difference in a name, ordinal, type or value is significant
+        self.assertNotEqual ( x, build ( 2 ) )
+        self.assertNotEqual ( x.contentHash ( ), build ( 2 ).contentHash ( ) )
+        for first, second in ( ( ( 1, 'a' ), ( 1, 'b' ) ),
+                               ( ( 1, None, 1 ), ( 1, None, 2 ) ),
+                               ( ( 1, 'a' ), ( 1, None ) ),
+                               ( ( 1, 'a' ), ( 2, 'a' ) ),
+                               ( ( 1.0, 'a' ), ( 1, 'a' ) ),
+                               ( ( 'abc', 'a' ), ( 'abd', 'a' ) ) ):
+            one, two = Message ( ), Message ( )
+            one.addField ( *first )
+            two.addField ( *second )
+            self.assertNotEqual ( one, two )
+            self.assertNotEqual ( one.contentHash ( ), two.contentHash ( ) )
+
+        # Positive and negative zero are equal
+        zero = Message ( )
+        zero.addFieldF64 ( 0.0 )
+        negzero = Message ( )
+        negzero.addFieldF64 ( -0.0 )
+        self.assertEqual ( zero, negzero )
+        self.assertEqual ( zero.contentHash ( ), negzero.contentHash ( ) )
+
+        self.assertFalse ( x == 'not a message' )
+        self.assertTrue ( x != None )
+        self.assertEqual ( Message ( ), Message ( ) )
+
+
+    def testFreeze ( self ):
+        message = Message ( )
+        message.addField ( 1, 'one' )
+        message.addField ( Message ( ), 'sub' )
+        self.assertRaises ( TypeError, hash, message )
+        self.assertFalse ( message.isFrozen ( ) )
+
+        message.freeze ( )
+        self.assertTrue ( message.isFrozen ( ) )
+        for call in ( lambda: message.addField ( 2, 'two' ),
+                      lambda: message.addFieldI32 ( 2 ),
+                      lambda: message.addFieldRawDate ( 2012, 1, 1 ),
+                      lambda: message.addFieldRawTime ( fudgepyc.types.PRECISION_SECOND, 1, 2, 3 ),
+                      lambda: message.addFieldRawDateTime ( fudgepyc.types.PRECISION_DAY, 2012, 1, 1 ),
+                      lambda: message.addFields ( [ ( 2, 'two' ) ] ),
+                      lambda: message [ 'sub' ].value ( ).addField ( 2 ) ):
+            self.assertRaises ( TypeError, call )
+        self.assertEqual ( len ( message ), 2 )
+        self.assertEqual ( len ( message [ 'sub' ].value ( ) ), 0 )
+
+        # Frozen messages can be dictionary keys and set members
+        duplicate = message.copy ( )
+        self.assertFalse ( duplicate.isFrozen ( ) )
+        duplicate.freeze ( )
+        self.assertEqual ( hash ( message ), hash ( duplicate ) )
+        self.assertEqual ( len ( set ( [ message, duplicate ] ) ), 1 )
+        self.assertEqual ( { message : 1 } [ duplicate ], 1 )
+
+        # Copies are not frozen
+        duplicate = message.copy ( )
+        duplicate.addField ( 2, 'two' )
+        self.assertEqual ( len ( duplicate ), 3 )
+
+        # Shallow copies of a frozen message don't share its sub-messages
+        reference = message.copy ( )
+        reference.freeze ( )
+        for duplicate in ( copy.copy ( message ), message.copy ( deep = False ) ):
+            self.assertFalse ( duplicate.isFrozen ( ) )
+            duplicate [ 'sub' ].value ( ).addField ( 2 )
+            self.assertEqual ( len ( duplicate [ 'sub' ].value ( ) ), 1 )
+        self.assertEqual ( len ( message [ 'sub' ].value ( ) ), 0 )
+        self.assertEqual ( message, reference )
+        self.assertEqual ( hash ( message ), hash ( reference ) )
+
+        # Freezing a shallow copy also freezes the sub-messages it shares
+        # with the original, even those the original hasn't wrapped yet
+        encoded = fudgepyc.Envelope ( message.copy ( ) ).encode ( )
+        for makecopy in ( copy.copy, lambda m: m.copy ( deep = False ) ):
+            original = fudgepyc.Envelope.decode ( encoded ).message ( )
+            duplicate = makecopy ( original )
+            duplicate.freeze ( )
+            before = hash ( duplicate )
+            self.assertFalse ( original.isFrozen ( ) )
+            self.assertRaises ( TypeError, original [ 'sub' ].value ( ).addField, 2 )
+            self.assertEqual ( len ( duplicate [ 'sub' ].value ( ) ), 0 )
+            self.assertEqual ( hash ( duplicate ), before )
+            original.addField ( 2, 'two' )
+            self.assertEqual ( len ( duplicate ), 2 )
+
+
+    def testArrayBuffers ( self ):
+        message = Message ( )
+        message.addFieldI16Array ( [ -1, 2, 3 ], 'i16' )
+        message.addFieldI32Array ( [ -1, 2, 70000 ], 'i32' )
+        message.addFieldI64Array ( [ -1, 2, 2 ** 40 ], 'i64' )
+        message.addFieldF32Array ( [ 1.5, -2.5 ], 'f32' )
+        message.addFieldF64Array ( [ 0.25 * i for i in range ( 1000 ) ], 'f64' )
+        message.addFieldByteArray ( self.__generateByteArray ( 10 ), 'bytes' )
+        message.addField4ByteArray ( [ 1, 2, 3, 4 ], 'fixed' )
+        message.addFieldF64Array ( [ ], 'empty' )
+
+        for name, typecode, itemsize in ( ( 'i16', 'h', 2 ),
+                                          ( 'i32', 'i', 4 ),
+                                          ( 'i64', 'q', 8 ),
+                                          ( 'f32', 'f', 4 ),
+                                          ( 'f64', 'd', 8 ),
+                                          ( 'bytes', 'b', 1 ),
+                                          ( 'fixed', 'b', 1 ),
+                                          ( 'empty', 'd', 8 ) ):
+            field = message [ name ]
+            view = field.asBuffer ( )
+            self.assertEqual ( view.format, typecode )
+            self.assertEqual ( view.itemsize, itemsize )
+            self.assertEqual ( view.shape, ( len ( field ), ) )
+            self.assertTrue ( view.readonly )
+            self.assertEqual ( view.tobytes ( ), field.bytes ( ) )
+            self.assertEqual ( str ( buffer ( field ) ), field.bytes ( ) )
+            self.assertEqual ( memoryview ( field ).format, typecode )
+
+        # The elements can be read without creating a list first
+        values = array.array ( 'd', message [ 'f64' ].asBuffer ( ).tobytes ( ) )
+        self.assertEqual ( values.tolist ( ), message [ 'f64' ].value ( ) )
+
+        # The view keeps the message alive
+        view = message [ 'f64' ].asBuffer ( )
+        del message
+        self.assertEqual ( array.array ( 'd', view.tobytes ( ) ) [ 999 ], 249.75 )
+
+        message = Message ( )
+        message.addField ( 1, 'int' )
+        message.addField ( u'string', 'str' )
+        for field in message:
+            self.assertRaises ( TypeError, field.asBuffer )
+            self.assertRaises ( TypeError, memoryview, field )
+            self.assertRaises ( TypeError, fudgepyc.Envelope.decode, field )
+
+
+    def testArrayIngestion ( self ):
+        doubles = array.array ( 'd', [ 0.5 * i for i in range ( 50000 ) ] )
+        message = Message ( )
+        message.addFieldF64Array ( doubles, 'f64' )
+        message.addField ( array.array ( 'h', [ -1, 0, 1 ] ), 'i32', type = fudgepyc.types.INT_ARRAY )
+        message.addFieldI16Array ( bytearray ( [ 0, 128, 255 ] ), 'i16' )
+        message.addFieldF32Array ( array.array ( 'i', [ 1, -2 ] ), 'f32' )
+        message.addFieldI64Array ( array.array ( 'f', [ 1.75, -2.75 ] ), 'i64' )
+        message.addFieldF64Array ( message [ 'f32' ], 'field' )
+        message.addFieldI32Array ( array.array ( 'l' ), 'empty' )
+
+        self.assertEqual ( message [ 'f64' ].value ( ), doubles.tolist ( ) )
+        self.assertEqual ( message [ 'i32' ].value ( ), [ -1, 0, 1 ] )
+        self.assertEqual ( message [ 'i16' ].value ( ), [ 0, 128, 255 ] )
+        self.assertEqual ( message [ 'f32' ].value ( ), [ 1.0, -2.0 ] )
+        self.assertEqual ( message [ 'i64' ].value ( ), [ 1, -2 ] )
+        self.assertEqual ( message [ 'field' ].value ( ), [ 1.0, -2.0 ] )
+        self.assertEqual ( message [ 'empty' ].value ( ), [ ] )
+
+        # Narrowing is range checked, as for sequences
+        self.assertRaises ( OverflowError, message.addFieldI16Array, array.array ( 'i', [ 1, 40000 ] ) )
+        self.assertRaises ( OverflowError, message.addFieldI16Array, array.array ( 'i', [ -40000, 1 ] ) )
+        self.assertRaises ( OverflowError, message.addFieldI64Array, array.array ( 'L', [ 2 ** 63 ] ) )
+        self.assertRaises ( ValueError, message.addFieldI32Array, '123' )
+        self.assertEqual ( len ( message ), 7 )
+
+
+    def testTimezone ( self ):
+        Timezone = fudgepyc.timezone.Timezone
+        self.assertTrue ( isinstance ( Timezone ( 4 ), datetime.tzinfo ) )
+        self.assertTrue ( Timezone ( 4 ) is Timezone ( quarters = 4 ) )
+        self.assertEqual ( Timezone ( -5 ).utcoffset ( None ), datetime.timedelta ( minutes = -75 ) )
+        self.assertEqual ( Timezone ( -5 ).tzname ( None ), '-115' )
+        self.assertEqual ( Timezone ( 4 ).tzname ( None ), '100' )
+        self.assertEqual ( Timezone ( -44 ).tzname ( None ), '-1100' )
+        self.assertEqual ( Timezone ( 0 ).dst ( None ), None )
+        self.assertEqual ( repr ( Timezone ( -32 ) ), 'fudgepyc.timezone.Timezone(-32)' )
+        self.assertRaises ( TypeError, Timezone, 'x' )
+
+        # Offsets of a day or more can be created, but not used
+        self.assertFalse ( Timezone ( 96 ) is Timezone ( 96 ) )
+        self.assertRaises ( ValueError, datetime.time ( 1, 2, 3, 0, Timezone ( 96 ) ).utcoffset )
+
+        # Decoded values share the same instances
+        message = Message ( )
+        message.addFieldRawTime ( fudgepyc.types.PRECISION_SECOND, 1, 2, 3, 0, 4, 'a' )
+        message.addFieldRawTime ( fudgepyc.types.PRECISION_SECOND, 1, 2, 3, 0, 4, 'b' )
+        self.assertTrue ( message [ 'a' ].value ( ).tzinfo is Timezone ( 4 ) )
+        self.assertTrue ( message [ 'b' ].value ( ).tzinfo is Timezone ( 4 ) )
+
+        value = datetime.datetime ( 2012, 3, 4, 5, 6, 7, 0, Timezone ( -20 ) )
+        self.assertEqual ( pickle.loads ( pickle.dumps ( value ) ), value )
+        self.assertTrue ( copy.deepcopy ( value ).tzinfo is Timezone ( -20 ) )
+
+
+    def testDateTimeConversion ( self ):
+        Timezone = fudgepyc.timezone.Timezone
+        values = [ datetime.date ( 2012, 2, 29 ),
+                   datetime.time ( 23, 59, 58, 999999 ),
+                   datetime.time ( 1, 2, 3, 4, Timezone ( -20 ) ),
+                   datetime.time ( 1, 2, 3, 4, TestTimeZone ( ) ),
+                   datetime.datetime ( 9999, 12, 31, 23, 59, 59, 999999 ),
+                   datetime.datetime ( 1, 1, 1, 0, 0, 0, 0, Timezone ( 95 ) ),
+                   datetime.datetime ( 2012, 3, 4, 5, 6, 7, 8, TestTimeZone ( ) ) ]
+        message = Message ( )
+        for value in values:
+            message.addField ( value )
+
+        for field, value in zip ( message, values ):
+            self.assertEqual ( field.value ( ), value )
+            self.assertEqual ( type ( field.value ( ) ), type ( value ) )
+
+        # Timezone and other tzinfo implementations give the same offset
+        self.assertEqual ( message.getFieldAtIndex ( 2 ).getRawTime ( ) [ 5 ], -20 )
+        self.assertEqual ( message.getFieldAtIndex ( 3 ).getRawTime ( ) [ 5 ], -20 )
+        self.assertEqual ( message.getFieldAtIndex ( 1 ).getRawTime ( ) [ 5 ], None )
+        self.assertTrue ( message.getFieldAtIndex ( 6 ).value ( ).tzinfo is Timezone ( -20 ) )
+
+
+    def testEpochNanos ( self ):
+        nanos = 1330837567000000123     # 2012-03-04 05:06:07.000000123 UTC
+        precision = fudgepyc.types.PRECISION_NANOSECOND
+
+        message = Message ( )
+        message.addFieldDateTimeFromEpoch ( nanos, name = 'utc' )
+        message.addFieldDateTimeFromEpoch ( nanos, offset = -20, name = 'est' )
+        message.addFieldDateTimeFromEpoch ( -1, name = 'pre' )
+        message.addField ( datetime.date ( 2012, 2, 29 ), name = 'date' )
+        message.addField ( datetime.time ( 1, 2, 3, 4 ), name = 'time' )
+        message.addField ( 1, name = 'int' )
+
+        self.assertEqual ( message [ 'utc' ].getRawDateTime ( ),
+                           ( precision, 2012, 3, 4, 5, 6, 7, 123, None ) )
+        self.assertEqual ( message [ 'est' ].getRawDateTime ( ),
+                           ( precision, 2012, 3, 4, 0, 6, 7, 123, -20 ) )
+        self.assertEqual ( message [ 'pre' ].getRawDateTime ( ),
+                           ( precision, 1969, 12, 31, 23, 59, 59, 999999999, None ) )
+
+        self.assertEqual ( message [ 'utc' ].getEpochNanos ( ), nanos )
+        self.assertEqual ( message [ 'est' ].getEpochNanos ( ), nanos )
+        self.assertEqual ( message [ 'pre' ].getEpochNanos ( ), -1 )
+        self.assertEqual ( message [ 'date' ].getEpochNanos ( ), 1330473600000000000 )
+        self.assertEqual ( message [ 'time' ].getEpochNanos ( ), 3723000004000 )
+        self.assertRaises ( fudgepyc.Exception, message [ 'int' ].getEpochNanos )
+        self.assertRaises ( OverflowError, message.addFieldDateTimeFromEpoch, nanos, offset = 128 )
+        self.assertRaises ( TypeError, message.addFieldDateTimeFromEpoch, nanos, ordinal = 1.5 )
+
+        # By default values are datetimes, unless asked for as nanoseconds
+        encoded = fudgepyc.Envelope ( message ).encode ( )
+        self.assertEqual ( type ( fudgepyc.Envelope.decode ( encoded ).message ( ) [ 'utc' ].value ( ) ),
+                           datetime.datetime )
+        decoded = fudgepyc.Envelope.decode ( encoded, epochnanos = True ).message ( )
+        for name in [ 'utc', 'est', 'pre', 'date', 'time' ]:
+            self.assertEqual ( decoded [ name ].value ( ), message [ name ].getEpochNanos ( ) )
+        self.assertEqual ( decoded [ 'int' ].value ( ), 1 )
+
+        loaded = fudgepyc.loads ( encoded, epochnanos = True )
+        self.assertEqual ( loaded [ 'est' ], nanos )
+
+
+    def testStringConversion ( self ):
+        values = [ '', 'ascii', u'', u'ascii', u'caf\xe9', u'\u65e5\u672c',
+                   u'\U0001d11e clef', u'mixed \xe9 \U0001f600' ]
+        message = Message ( )
+        for value in values:
+            message.addField ( value )
+        encoded = fudgepyc.Envelope ( message ).encode ( )
+
+        # Strings are always Unicode by default
+        decoded = fudgepyc.Envelope.decode ( encoded ).message ( )
+        for index, value in enumerate ( values ):
+            self.assertEqual ( decoded.getFieldAtIndex ( index ).value ( ), unicode ( value ) )
+            self.assertEqual ( type ( decoded.getFieldAtIndex ( index ).value ( ) ), unicode )
+
+        # Unless ASCII-only strings are requested as str
+        decoded = fudgepyc.Envelope.decode ( encoded, asciistr = True ).message ( )
+        for index, value in enumerate ( values ):
+            field = decoded.getFieldAtIndex ( index )
+            self.assertEqual ( field.value ( ), value )
+            self.assertEqual ( type ( field.value ( ) ), index < 4 and str or unicode )
+
+        loaded = fudgepyc.loads ( fudgepyc.dumps ( { 'name' : 'value', u'n\xe9' : u'v\xe9' } ),
+                                  asciistr = True )
+        self.assertEqual ( loaded, { 'name' : 'value', u'n\xe9' : u'v\xe9' } )
+        self.assertEqual ( type ( loaded [ 'name' ] ), str )
+        self.assertEqual ( type ( [ key for key in loaded if key == 'name' ] [ 0 ] ), str )
+
+
     def __generateByteArray ( self, size ):
         return [ idx % 256 - 128 for idx in range ( 0, size ) ]
 
@@ -540,5 +1159,20 @@ def suite ( ):
               'testIntegerFieldDowncasting',
               'testFieldCoercion',
               'testDateTimeFields',
-              'testIntegerFields' ]
+              'testIntegerFields',
+              'testAddFields',
+              'testNameCache',
+              'testMessageTemplate',
+              'testIteration',
+              'testIndexedLookup',
+              'testGetAll',
+              'testCopy',
+              'testEquality',
+              'testFreeze',
+              'testArrayBuffers',
+              'testArrayIngestion',
+              'testTimezone',
+              'testDateTimeConversion',
+              'testEpochNanos',
+              'testStringConversion' ]
     return unittest.TestSuite ( map ( MessageTestCase, tests ) )